@@ -2,36 +2,57 @@
 #define HEURISTICS_H
 
 #include "movements.hpp"
+#include "workspace.hpp"
 
 #include <string>
 #include <cstring>
 
-// Greedy randomized construction of a feasible solution
-std::tuple<char*, int, char*> GreedyRandomized(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
+// Greedy randomized construction of a feasible solution (built in  S ).
+// The variables sharing a row with a selected one are dropped from the
+// candidates at once, so the RCL only holds variables that fit and the
+// solution is maximal once no candidate is left.
+// order  holds the variables by decreasing utility ( argsort(n, U) , sorted
+// again on each call if null). The buffers are taken from  W  (allocated for
+// the call if null).
+void GreedyRandomized(
+    SolutionState& S,
     const float* U,
-    const float alpha);
+    const float alpha,
+    const std::vector<int>* order = nullptr,
+    Workspace* W = nullptr);
+
+// Greedy randomized construction with adaptive utilities : the utility of a
+// candidate is its cost divided by 1 + the number of candidates it would
+// eliminate (counted once per shared row). The count of candidates of a row
+// is only updated once it has halved (it is then at most twice the exact
+// one), so each row is visited O(|row|) times in all and the construction
+// costs O(nnz log n) with the two indexed heaps (max and min utility) of
+// the candidates : about 5.5 ms on pb_2000rnd0100 (0.25 ms for
+// GreedyRandomized()), 0.3 ms on pb_500rnd0700 (0.07 ms).
+// If  W  is given it must have the buffers of the rows (see Workspace).
+void GreedyAdaptive(SolutionState& S, const float alpha, Workspace* W = nullptr);
 
-// Greedy improvement of a feasible solution through (deep) local search
+// Greedy improvement of the feasible solution  S  through (deep) local
+// search : the exchanges of  neighbourhoods  are applied in turn, each one
+// as long as it improves  S .
+// If  queue  is true, the neighbourhoods with  p = 1  are all explored at
+// once by queueExchange() (only the variables whose blockers changed since
+// they were last looked at are tried again), the others are applied in
+// turn once the queue is empty. A (k,1)-exchange of the queue replaces
+// exactly the  k  blockers of the entering variable.
 void GreedyImprovement(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int z,
+    SolutionState& S,
     bool deep = true,
-    char* column = nullptr);
+    const std::vector<Neighbourhood>& neighbourhoods = { {2, 1}, {1, 1}, {0, 1} },
+    bool queue = false);
 
-// GRASP for the Set Packing Problem
+// GRASP for the Set Packing Problem (solutions built by GreedyAdaptive() if
+// adaptive  is true, by GreedyRandomized() otherwise)
 void ReactiveGRASP(
     const int m,
     const int n,
     const int* C,
-    const char* A,
+    const ConstraintMatrix* A,
     const float* U,
     std::vector<int>& zInits,
     std::vector<int>& zAmels,
@@ -42,6 +63,9 @@ void ReactiveGRASP(
     const double delta,
     int nbIter = 100,
     bool deep = true,
-    bool parallel = true);
+    bool parallel = true,
+    const std::vector<Neighbourhood>& neighbourhoods = { {2, 1}, {1, 1}, {0, 1} },
+    bool queue = false,
+    bool adaptive = false);
 
 #endif /* end of include guard: HEURISTICS_H */
@@ -17,6 +17,8 @@
 #include <exception>
 #include <stdexcept>
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 #include <glpk.h>
 
@@ -35,10 +37,8 @@
   __m_time_var_b__ = __m_time__(); \
   t = __DURATION__(__m_time_var_b__ - __m_time_var_a__).count();
 
-// Macro that returns a 1D index from 2D coordinates (row and col)
-#define _INDEX(row, col, nCols) (col * nCols + row)
-// Shorter version. CAUTION: only use if  n  is in the scope
-#define INDEX(row, col) _INDEX(row, col, n)
+// Alignment (in bytes) of the arrays of the binary cache (one cache line)
+#define _PAD_ 64
 
 // Macros for color printing
 #define _CLR   "\u001B[0m"
@@ -47,19 +47,119 @@
 #define _CLB   "\u001B[36m"
 #define _CLP   "\033[1;35m"
 
+// Type of the number of non-zero elements of a sparse matrix and of the
+// offsets in its arrays (it can exceed 2^31 on very large instances). The
+// row and variable indices themselves stay  int  (32 bits), which keeps the
+// index arrays compact.
+typedef int64_t nnz_t;
+
+// Conflict graph of the variables :  i  and  j  are neighbours if they share
+// a row of the matrix of constraints (they can't be both set to 1).
+// The neighbours of  j  are  neighbours(j)[0] ... neighbours(j)[degree(j)-1]
+// (sorted). If the graph is dense enough its adjacency matrix is also
+// stored as bitsets of  words  64-bit words per variable in  matrix .
+struct ConflictGraph {
+  int n = 0, words = 0;
+  std::vector<nnz_t> adjBeg;
+  std::vector<int> adj;
+  std::vector<uint64_t> matrix;
+
+  bool built() const { return !adjBeg.empty(); }
+  const int* neighbours(int j) const { return adj.data() + adjBeg[j]; }
+  int degree(int j) const { return adjBeg[j+1] - adjBeg[j]; }
+  // Returns true if  i  and  j  share a row (O(1) with the adjacency
+  // matrix, O(log(degree)) otherwise)
+  bool conflict(int i, int j) const {
+    if(!matrix.empty())
+      return matrix[(size_t)i * words + j / 64] >> (j % 64) & 1;
+    if(degree(i) > degree(j)) std::swap(i, j);
+    return std::binary_search(neighbours(i), neighbours(i) + degree(i), j);
+  }
+  // Memory used by the graph (in bytes)
+  size_t memory() const {
+    return adjBeg.capacity() * sizeof(nnz_t) + adj.capacity() * sizeof(int)
+      + matrix.capacity() * sizeof(uint64_t);
+  }
+};
+
+// Binary matrix of constraints stored in sparse form in both directions :
+//  *  colBeg  and  colRow  the rows covered by each variable (CSC)
+//  *  rowBeg  and  rowVar  the variables appearing in each row (CSR)
+// Only the  nnz  non-zero elements are stored and the indices are sorted.
+// colBeg  and  rowBeg  are 64-bit offsets,  colRow  and  rowVar  32-bit
+// indices.
+// The conflict graph of the variables is only available once
+// buildConflicts()  has been called.
+struct ConstraintMatrix {
+  int m = 0, n = 0;
+  nnz_t nnz = 0;
+  std::vector<nnz_t> colBeg, rowBeg;
+  std::vector<int> colRow, rowVar;
+  ConflictGraph conflicts;
+
+  // Rows covered by variable  j  are  rows(j)[0] ... rows(j)[nbRows(j)-1]
+  const int* rows(int j) const { return colRow.data() + colBeg[j]; }
+  int nbRows(int j) const { return colBeg[j+1] - colBeg[j]; }
+  // Variables appearing in row  i  are  vars(i)[0] ... vars(i)[nbVars(i)-1]
+  const int* vars(int i) const { return rowVar.data() + rowBeg[i]; }
+  int nbVars(int i) const { return rowBeg[i+1] - rowBeg[i]; }
+
+  // Memory used by the matrix (in bytes)
+  size_t memory() const;
+  // Builds the columns (CSC) from the rows (CSR)
+  void buildColumns();
+  // Builds  conflicts  from the sparse rows and columns (in parallel if
+  // parallel  is true)
+  void buildConflicts(bool parallel = true);
+
+  // Returns true if variables  i  and  j  share a row
+  bool share(int i, int j) const {
+    if(conflicts.built()) return conflicts.conflict(i, j);
+    const int *a = rows(i), *ea = a + nbRows(i), *b = rows(j), *eb = b + nbRows(j);
+    while(a != ea && b != eb) {
+      if(*a == *b) return true;
+      if(*a < *b) a++; else b++;
+    }
+    return false;
+  }
+};
+
 // Collect the unhidden filenames available in a given folder
 std::vector<std::string> getfname(std::string pathtofolder);
 
+// Reads  fname  (memory mapped and parsed in a single pass) and returns :
+//  *  C  the vector of coefficients from the objective function
+//  *  A  the binary matrix of constraints (sparse layout)
+// Throws std::runtime_error if  fname  can't be read or is malformed.
+std::tuple<std::unique_ptr<int[]>, std::unique_ptr<ConstraintMatrix>>
+  parseSPP(std::string fname);
+
 // Reads  fname  and returns :
 //  *  m  the number of constraints
 //  *  n  the number of variables
 //  *  C  the vector of coefficients from the objective function
-//  *  A  the binary matrix of constraints (as a 1D array)
+//  *  A  the binary matrix of constraints (sparse, see ConstraintMatrix)
 //  *  U  a vector of utilities computed for each variables
-std::tuple<int, int, std::unique_ptr<int[]>, std::unique_ptr<char[]>,
-  std::unique_ptr<float[]>> loadSPP(std::string fname);
+// If  cache  is true, the parsed instance is saved in a binary file next to
+//  fname  (see cacheName) and read back from it on the next calls, as long
+// as  fname  is unchanged (same size and same modification time or hash).
+// If  conflicts  is true, the conflict graph of  A  is built too.
+// If  tParse  isn't null, it receives the time spent parsing  fname  (0 if
+// the instance was read from the cache).
+std::tuple<int, int, std::unique_ptr<int[]>, std::unique_ptr<ConstraintMatrix>,
+  std::unique_ptr<float[]>> loadSPP(
+    std::string fname,
+    bool cache = false,
+    bool conflicts = false,
+    float* tParse = nullptr);
+
+// Name of the binary cache of  fname  (a hidden file in the same folder so
+// getfname() ignores it)
+std::string cacheName(std::string fname);
 
-// Models the SPP and run GLPK on instance  instance :
+// Models the SPP and run GLPK on instance  instance  (the time spent
+// building the model and solving it are reported separately,  tt  only
+// accumulates the solving time) :
 void modelSPP(
     std::string fname,
     std::string path = "",
@@ -69,13 +169,14 @@ void modelSPP(
 // Takes  C  ,  A  and  x  and returns :
 //  * true if  x  is feasible
 //  * false otherwise
+// All the rows are recomputed from scratch : the heuristics never call it
+// to test a move (see  SolutionState::isFeasible ), it only checks a solution.
 bool isFeasible(
     int m,
     int n,
     const int* C,
-    const char* A,
+    const ConstraintMatrix* A,
     const char* x,
-    const char* extColumn = nullptr,
     bool verbose = true);
 
 // Computes indirect sort of an array (decreasing order)
@@ -128,4 +229,11 @@ Iter select_randomly(Iter start, Iter end) {
   return select_randomly(start, end, gen);
 }
 
+// Returns an index in  [0, size)  at random (one generator per thread : it
+// is called by the constructions running in parallel)
+inline int random_index(int size) {
+  static thread_local std::mt19937 gen(std::random_device{}());
+  return std::uniform_int_distribution<>(0, size - 1)(gen);
+}
+
 #endif /* end of include guard: LIBRARYSPP_H */
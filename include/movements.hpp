@@ -1,104 +1,75 @@
 #ifndef MOVEMENTS_H
 #define MOVEMENTS_H
 
-#include "librarySPP.hpp"
+#include "solution.hpp"
 
-#include <deque>
-#include <forward_list>
+// Neighbourhood of the (k,p)-exchanges : up to  k  selected variables leave
+// x  and  p  unselected variables enter it
+struct Neighbourhood {
+  int k, p;
+};
 
-template<typename T>
-std::forward_list<int> findItems(int size, T* const arr, T target) {
-  std::forward_list<int> indices;
+// All the exchanges evaluate their moves on  S  without modifying it (see
+// SolutionState::gain and SolutionState::isFeasible) and only apply the
+// best one ( deep ) or the first improving one.
 
-  for(--size; size >= 0; size--) // Avoids creating extra variable
-    if(arr[size] == target)
-      indices.push_front(size);
-
-  return indices;
-}
-
-template<typename R>
-std::tuple<R, R> find01(int size, char* const arr) {
-  R idx0, idx1;
-
-  for(--size; size >= 0; size--) {
-    if(arr[size] == 0) idx0.push_front(size);
-    if(arr[size] == 1) idx1.push_front(size);
-  }
-
-  return std::make_tuple(idx0, idx1);
-}
-
-// Implements 01-exchange.
+// Implements 01-exchange (the free variable with the greatest cost is
+// inserted, see SolutionState::bestFree).
 // Returns true if an improved solution is found.
 bool zero_oneExchange(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column = nullptr);
+    SolutionState& S,
+    bool deep);
 
-// Implements 11-exchange
+// Implements 11-exchange (only the variables blocked by a single selected
+// variable are tried, against that variable, by decreasing cost until none
+// can improve on the best move).
 // Returns true if an improved solution is found.
 bool one_oneExchange(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column = nullptr);
-
-// Helper function for two_oneExchange()
-// compute all non-symmetrical pairs of indices (indices of the variables
-// set to 1) recursively so we don't have to store all the combinations
-//
-// CAUTION : since we use recursion we should be cautious of the program
-// stack size. Only things like the return address, the function arguments
-// and the variable used in the function are stored in the stack. Since we
-// don't initialize too much stuff in the function, the memory used comes (for
-// the most part) from storing the return address and function arguments on
-// stack. The size of the arguments should be around 70 bytes per call. We
-// stop at  recursion_depth == 2  and we make at most N-2 recursive calls
-// per level with N the number of ones in x.
-// In conclusion : we expect to use around (2N-4) * 70 Bytes of memory.
-// With a stack of size 1MB (125000 Bytes) we can use this function up to
-// around N = 894 (894 variables set to 1 in x).
-bool combinations(
-    // heuristic variables
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column,
-    bool* stop,
-    int* best_z,
-    std::tuple<int, int, int>& best_move,
-    // indices list (for variables set to 0)
-    const std::forward_list<int>& idx0,
-    // variables useful for recursion
-    int* pair_of_1,
-    std::forward_list<int>::iterator start,
-    std::forward_list<int>::iterator end,
-    int depth);
+    SolutionState& S,
+    bool deep);
 
-// Implements 21-exchange
+// Implements 21-exchange : only the unselected variables blocked by at most
+// two selected variables are tried, against their blockers (completed with
+// the cheapest selected variables), by decreasing cost until none can
+// improve on the best move. The best move has the same gain as the best
+// one over every pair of selected variables (see tests/exchange_test.cpp).
 // Returns true if an improved solution is found.
 bool two_oneExchange(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column = nullptr);
+    SolutionState& S,
+    bool deep);
+
+// Implements (k,p)-exchange for  p = 1  or  p = 2  (and  k <= _MOVE_MAX_ ) :
+// the variables entering x are blocked by at most  k  selected variables
+// (their blockers, which leave x). With  p = 2  the two variables must share
+// a blocker (pairs with no common blocker are two independent moves of the
+// p = 1  neighbourhood) : the second variable is taken from the rows of the
+// blockers of the first one. The candidates are tried by decreasing cost
+// until none can improve on the best move.
+// Returns true if an improved solution is found.
+bool kpExchange(
+    SolutionState& S,
+    Neighbourhood nb,
+    bool deep);
+
+// Implements the (k,1)-exchanges of  neighbourhoods  (the other ones are
+// ignored) driven by the queue of  S  : a variable popped from the queue
+// blocked by  k  selected variables replaces them if  (k,1)  is listed and
+// it improves  S  (the variables whose blocking count changes are queued
+// again). The first improving move is applied, or the best one among the
+// variables queued ( deep ), until no queued variable improves  S .
+// Returns true if an improved solution is found.
+bool queueExchange(
+    SolutionState& S,
+    const std::vector<Neighbourhood>& neighbourhoods,
+    bool deep);
+
+// Applies the exchange of neighbourhood  nb  (zero_oneExchange(),
+// one_oneExchange() and two_oneExchange() for 0-1, 1-1 and 2-1,
+// kpExchange() otherwise)
+// Returns true if an improved solution is found.
+bool exchange(
+    SolutionState& S,
+    Neighbourhood nb,
+    bool deep);
 
 #endif /* end of include guard: MOVEMENTS_H */
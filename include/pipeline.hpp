@@ -0,0 +1,95 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "librarySPP.hpp"
+#include "presolve.hpp"
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+// Instance as returned by loadSPP() (and presolveSPP() if asked, with
+// the mapping  P  to the original instance) with its load and presolve
+// times (in seconds) and its memory footprint (in bytes)
+struct LoadedInstance {
+  std::string name;
+  int m = -1, n = -1;
+  std::unique_ptr<int[]> C;
+  std::unique_ptr<ConstraintMatrix> A;
+  std::unique_ptr<float[]> U;
+  Postsolve P;
+  // t  the loading time,  tParse  the part spent parsing the text file (0
+  // if read from the cache) and  tp  the presolve time
+  float t = 0, tParse = 0, tp = 0;
+  size_t bytes = 0;
+};
+
+// Loads the instances  fnames  (in order) ahead of their use. If
+// background  is true they are loaded by a background thread as long as the
+// instances loaded but not yet returned by next() fit in  budget  bytes (one
+// instance is always loaded ahead whatever its size). Otherwise each
+// instance is loaded by next() itself.
+// The background thread builds the conflict graph on its own (the heuristics
+// already run on every OpenMP thread meanwhile). An exception thrown while
+// loading in the background is thrown again by next() once the instances
+// loaded before are returned.
+class InstancePrefetcher {
+  public:
+    InstancePrefetcher(
+        std::string path,
+        std::vector<std::string> fnames,
+        bool cache,
+        bool conflicts,
+        bool presolve,
+        size_t budget,
+        bool background = true);
+    ~InstancePrefetcher();
+    InstancePrefetcher(const InstancePrefetcher&) = delete;
+    InstancePrefetcher& operator=(const InstancePrefetcher&) = delete;
+
+    // Returns the next instance (waits until it is loaded)
+    LoadedInstance next();
+
+  private:
+    LoadedInstance load(const std::string& fname);
+    void run();
+
+    std::string path;
+    std::vector<std::string> fnames;
+    bool cache, conflicts, presolve, background, stop = false;
+    size_t budget, inFlight = 0, loaded = 0, taken = 0;
+    std::deque<LoadedInstance> ready;
+    std::exception_ptr error;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread worker;
+};
+
+// Runs the tasks pushed (in order) in a background thread so the caller
+// doesn't wait for them. If  background  is false, push() runs the task
+// right away.
+class TaskQueue {
+  public:
+    TaskQueue(bool background = true);
+    ~TaskQueue();
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    void push(std::function<void()> task);
+    // Waits until every task pushed so far is done
+    void wait();
+
+  private:
+    void run();
+
+    bool background, stop = false, busy = false;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread worker;
+};
+
+#endif /* end of include guard: PIPELINE_H */
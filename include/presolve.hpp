@@ -0,0 +1,40 @@
+#ifndef PRESOLVE_H
+#define PRESOLVE_H
+
+#include "librarySPP.hpp"
+
+// Mapping from a reduced instance (see presolveSPP) to the original one
+struct Postsolve {
+  int m = 0, n = 0;           // size of the original instance
+  int offset = 0;             // z of the variables fixed to 1
+  std::vector<int> col;       // original index of each remaining variable
+  std::vector<int> ones;      // original variables fixed to 1
+  // What was removed
+  int fixedCols = 0, dominatedCols = 0, redundantRows = 0;
+
+  // Returns the solution of the original instance matching the solution  x
+  // of the reduced one
+  std::vector<char> restore(const char* x) const;
+  // Returns the value in the original instance of a solution of value  z
+  // in the reduced one
+  int restore(int z) const { return z + offset; }
+};
+
+// Reduces the SPP ( m ,  n ,  C ,  A ,  U ) in place, until nothing changes :
+//  * variables with a cost <= 0 are fixed to 0
+//  * variables covering no row are fixed to 1
+//  * variable  j  is removed if another variable  k  covers a subset of the
+//    rows of  j  with a greater cost (or equal cost and fewer rows, or
+//    equal cost, same rows and smaller index)
+//  * rows with less than two variables are removed
+//  * row  r  is removed if its variables are a subset of the variables of
+//    another row (or are the same with a greater index)
+// The conflict graph of  A  is not built. Returns the mapping to restore solutions.
+Postsolve presolveSPP(
+    int& m,
+    int& n,
+    std::unique_ptr<int[]>& C,
+    std::unique_ptr<ConstraintMatrix>& A,
+    std::unique_ptr<float[]>& U);
+
+#endif /* end of include guard: PRESOLVE_H */
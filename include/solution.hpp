@@ -0,0 +1,181 @@
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+#include "librarySPP.hpp"
+
+// Maximum number of variables leaving or entering the solution in a move
+#define _MOVE_MAX_ 3
+
+// A move removes  out[0] ... out[nOut-1]  from the solution and then inserts
+// in[0] ... in[nIn-1]
+struct Move {
+  int nOut = 0, nIn = 0;
+  int out[_MOVE_MAX_], in[_MOVE_MAX_];
+
+  Move() {}
+  Move(std::initializer_list<int> o, std::initializer_list<int> i) {
+    for(int j : o) out[nOut++] = j;
+    for(int j : i) in[nIn++] = j;
+  }
+  bool empty() const { return !nOut && !nIn; }
+};
+
+// Solution of the SPP together with everything the heuristics need to
+// evaluate a move without modifying it :
+//  *  x  the values of the variables and  z  the objective value
+//  *  selected()  and  unselected()  the variables set to 1 and to 0 (in no
+//     particular order)
+//  *  blocking(j)  the number of selected variables sharing a row with  j ,
+//     blockingCost(j)  the sum of their costs and  owner(i)  the selected
+//     variable covering row  i  (or -1)
+//  *  the free variables (unselected and unblocked, the ones that can be
+//     set to 1) as a bitset over their rank by decreasing cost, topped by
+//     bitsets of the non-zero words of the level below up to a single word,
+//     so  bestFree()  reads one word per level (O(log n / log 64))
+//  *  a queue of the variables to look at again (see  nextCandidate() ) :
+//     a variable is queued when it leaves x or its blocking count changes
+// gain()  and  isFeasible()  only read the state, in O(nnz) of the columns
+// of the move.  apply()  changes it (in the same time) and the last applied
+// move can be reverted with  undo() .
+class SolutionState {
+  public:
+    SolutionState(int m, int n, const int* C, const ConstraintMatrix* A);
+
+    // Resets to the empty solution ( x = 0 )
+    void reset();
+    // Resets to the solution  x  (assumed feasible)
+    void assign(const char* x);
+
+    int m() const { return _m; }
+    int n() const { return _n; }
+    int z() const { return _z; }
+    const char* x() const { return _x.data(); }
+    const std::vector<int>& selected() const { return _sel; }
+    const std::vector<int>& unselected() const { return _unsel; }
+    // All the variables by decreasing cost ( j  is at position  rank(j) )
+    const std::vector<int>& byCost() const { return _byCost; }
+    int rank(int j) const { return _rank[j]; }
+    const ConstraintMatrix* matrix() const { return _A; }
+    const int* costs() const { return _C; }
+    int blocking(int j) const { return _block[j]; }
+    int blockingCost(int j) const { return _blockCost[j]; }
+    int owner(int i) const { return _owner[i]; }
+    // Returns true if variable  j  can be set to 1
+    bool isFree(int j) const { return _free[0][_rank[j] / 64] >> (_rank[j] % 64) & 1; }
+    // Free variable with the greatest cost (-1 if none) : the first non-zero
+    // word of each level is given by the level above
+    int bestFree() const {
+      size_t i(0);
+      if(!_free.back()[0]) return -1;
+      for(size_t l = _free.size(); l-- > 0; ) i = i * 64 + __builtin_ctzll(_free[l][i]);
+      return _byCost[i];
+    }
+    // Writes the (at most  max ) selected variables sharing a row with  j
+    // in  out  and returns how many were written. Any unselected  j  with
+    // blocking(j) == nOut  and whose blockers are  out[0] ... out[nOut-1]
+    // can replace them.
+    int blockers(int j, int* out, int max) const {
+      int nb(0);
+      const ConstraintMatrix* A(_A);
+      for(const int *r = A->rows(j), *e = r + A->nbRows(j); r != e && nb < max; r++)
+        if(_owner[*r] != -1 && std::find(out, out + nb, _owner[*r]) == out + nb)
+          out[nb++] = _owner[*r];
+      return nb;
+    }
+
+    // Pops a variable from the queue (-1 if it is empty). A variable is only
+    // queued once until it is popped (its "don't look" bit is then set).
+    int nextCandidate() {
+      if(!_qSize) return -1;
+      int j(_queue[_qHead]);
+      _qHead = (_qHead + 1) % _n, _qSize--, _look[j] = 0;
+      return j;
+    }
+    // Number of variables in the queue
+    int queued() const { return _qSize; }
+    // Queues  j  (if it isn't already)
+    void wake(int j) {
+      if(_look[j]) return ;
+      _look[j] = 1, _queue[(_qHead + _qSize) % _n] = j, _qSize++;
+    }
+
+    // Variation of  z  if  mv  is applied
+    int gain(const Move& mv) const {
+      int g(0);
+      for(int t = 0; t < mv.nOut; t++) g -= _C[mv.out[t]];
+      for(int t = 0; t < mv.nIn; t++) g += _C[mv.in[t]];
+      return g;
+    }
+    // Returns true if applying  mv  keeps the solution feasible (only the
+    // rows of the variables entering the solution are checked : each one
+    // must be free or owned by a leaving variable)
+    bool isFeasible(const Move& mv) const {
+      const ConstraintMatrix* A(_A);
+      for(int t = 0; t < mv.nOut; t++) if(!_x[mv.out[t]]) return false;
+      for(int t = 0; t < mv.nIn; t++) {
+        if(_x[mv.in[t]]) return false;
+        for(const int *r = A->rows(mv.in[t]), *e = r + A->nbRows(mv.in[t]); r != e; r++)
+          if(_owner[*r] != -1
+              && std::find(mv.out, mv.out + mv.nOut, _owner[*r]) == mv.out + mv.nOut)
+            return false;
+        for(int s = 0; s < t; s++) if(A->share(mv.in[s], mv.in[t])) return false;
+      }
+      return true;
+    }
+    // Applies  mv  (assumed feasible)
+    void apply(const Move& mv);
+    // Reverts the last move applied (if any)
+    void undo();
+
+    // Sets  x[j]  to 1 (assumed to fit) or to 0
+    void insert(int j);
+    void remove(int j);
+
+  private:
+    int _m, _n, _z;
+    const int* _C;
+    const ConstraintMatrix* _A;
+    std::vector<char> _x;
+    // _pos[j]  is the position of  j  in  _sel  or in  _unsel
+    std::vector<int> _sel, _unsel, _pos;
+    std::vector<int> _block, _blockCost, _owner;
+    // _byCost[r]  is the variable of rank  r  and  _rank[j]  the rank of  j
+    std::vector<int> _byCost, _rank;
+    // _free[0]  has a bit per rank,  _free[l+1]  a bit per word of  _free[l]
+    // (set if the word isn't zero) and the last level a single word
+    std::vector<std::vector<uint64_t>> _free;
+    // Circular queue of the variables to look at ( _look[j]  if queued)
+    std::vector<int> _queue;
+    std::vector<char> _look;
+    int _qHead, _qSize;
+    // Stamps used to count each neighbour once when the conflict graph of
+    // A  isn't built
+    std::vector<int64_t> _mark;
+    int64_t _stamp;
+    Move _last;
+
+    // Adds  v  to the blocking count of every variable sharing a row with  j
+    void block(int j, int v);
+    // Adds  v  to the blocking count of  k  (which becomes free or not) and
+    // v * c  to its blocking cost
+    void count(int k, int v, int c) {
+      bool wasFree(!_block[k]);
+      _block[k] += v, _blockCost[k] += v * c;
+      if(wasFree != !_block[k] && !_x[k]) setFree(k, !_block[k]);
+      wake(k);
+    }
+    // Sets the bit of  j  then the ones of its words in the levels above,
+    // as long as a word changes from (or to) zero
+    void setFree(int j, bool f) {
+      size_t r(_rank[j]);
+      for(size_t l = 0; l < _free.size(); l++, r /= 64) {
+        uint64_t& w(_free[l][r / 64]);
+        bool wasZero(!w);
+        if(f) w |= uint64_t(1) << (r % 64);
+        else  w &= ~(uint64_t(1) << (r % 64));
+        if(f ? !wasZero : w) break;
+      }
+    }
+};
+
+#endif /* end of include guard: SOLUTION_H */
@@ -0,0 +1,147 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <vector>
+#include <functional>
+
+#include "librarySPP.hpp"
+
+// Candidates of a construction : positions  0..n-1  of an order, the ones
+// still insertable counted in a Fenwick tree so that counting the candidates
+// before a position and finding the  r -th one both take O(log n)
+class Candidates {
+  public:
+    Candidates(int n) : _n(n), _size(n), _tree(n + 1), _in(n), _top(1) {
+      while(_top * 2 <= n) _top *= 2;
+      reset();
+    }
+
+    // Every position is a candidate again
+    void reset() {
+      _size = _n;
+      std::fill(_tree.begin(), _tree.end(), 0);
+      std::fill(_in.begin(), _in.end(), 1);
+      for(int i = 1; i <= _n; i++) {
+        _tree[i] += 1;
+        if(i + (i & -i) <= _n) _tree[i + (i & -i)] += _tree[i];
+      }
+    }
+
+    int size() const { return _size; }
+
+    // Number of candidates among the positions  [0, pos)
+    int count(int pos) const {
+      int c(0);
+      for(; pos > 0; pos -= pos & -pos) c += _tree[pos];
+      return c;
+    }
+
+    // Position of the  r -th candidate ( r  from 1 to  size() )
+    int find(int r) const {
+      int pos(0);
+      for(int step = _top; step; step /= 2)
+        if(pos + step <= _n && _tree[pos + step] < r)
+          pos += step, r -= _tree[pos];
+      return pos;
+    }
+
+    void erase(int pos) {
+      if(!_in[pos]) return;
+      _in[pos] = 0, _size--;
+      for(pos++; pos <= _n; pos += pos & -pos) _tree[pos]--;
+    }
+
+  private:
+    int _n, _size;
+    std::vector<int> _tree;
+    std::vector<char> _in;
+    int _top;
+};
+
+// Heap of variables indexed by variable (so that a variable can be erased or
+// its key updated in O(log n)) :  better(u[a], u[b])  if  a  goes above  b
+template<typename Better>
+class IndexedHeap {
+  public:
+    IndexedHeap(const std::vector<float>& u) : _u(u), _at(u.size(), -1) {
+      _h.reserve(u.size());
+    }
+
+    int size() const { return _h.size(); }
+    int top() const { return _h[0]; }
+    // i -th variable of the heap (its children are at  2i+1  and  2i+2 )
+    int at(int i) const { return _h[i]; }
+    bool contains(int v) const { return _at[v] != -1; }
+
+    void clear() {
+      for(int v : _h) _at[v] = -1;
+      _h.clear();
+    }
+
+    void push(int v) {
+      _at[v] = _h.size(), _h.push_back(v);
+      up(_at[v]);
+    }
+
+    void erase(int v) {
+      int i(_at[v]), last(_h.back());
+      _h.pop_back(), _at[v] = -1;
+      if(last == v) return;
+      _h[i] = last, _at[last] = i;
+      update(last);
+    }
+
+    // To call once  u[v]  has changed
+    void update(int v) { down(up(_at[v])); }
+
+  private:
+    int up(int i) {
+      for(int p = (i - 1) / 2; i && _better(_u[_h[i]], _u[_h[p]]); i = p, p = (i - 1) / 2)
+        swap(i, p);
+      return i;
+    }
+
+    void down(int i) {
+      for(int c = 2 * i + 1, n = _h.size(); c < n; i = c, c = 2 * i + 1) {
+        if(c + 1 < n && _better(_u[_h[c+1]], _u[_h[c]])) c++;
+        if(!_better(_u[_h[c]], _u[_h[i]])) return;
+        swap(i, c);
+      }
+    }
+
+    void swap(int i, int k) {
+      std::swap(_h[i], _h[k]);
+      _at[_h[i]] = i, _at[_h[k]] = k;
+    }
+
+    const std::vector<float>& _u;
+    std::vector<int> _h, _at;
+    Better _better;
+};
+
+// Buffers of the constructions (GreedyRandomized() and GreedyAdaptive())
+// for an instance with  n  variables : allocated once and reused by every
+// construction, so that a GRASP iteration doesn't allocate anything.
+// The buffers of the rows ( live ,  snap ,  len  and  rowVar ) are only
+// allocated if  A  is given (GreedyAdaptive() needs them).
+// The heaps refer to  u , a workspace can't be copied.
+struct Workspace {
+  Workspace(int n, const ConstraintMatrix* A = nullptr) : cand(n), pos(n),
+    conf(n), u(n), seen(n, 0), hi(u), lo(u) {
+    RCL.reserve(n), dropped.reserve(n), touched.reserve(n);
+    if(A) live.resize(A->m), snap.resize(A->m), len.resize(A->m),
+      rowVar.resize(A->nnz);
+  }
+  Workspace(const Workspace&) = delete;
+  Workspace& operator=(const Workspace&) = delete;
+
+  Candidates cand;
+  std::vector<int> pos, conf, RCL, dropped, touched;
+  std::vector<int> live, snap, len, rowVar;
+  std::vector<float> u;
+  std::vector<char> seen;
+  IndexedHeap<std::greater<float>> hi;
+  IndexedHeap<std::less<float>> lo;
+};
+
+#endif /* end of include guard: WORKSPACE_H */
@@ -1,72 +1,168 @@
 #include "heuristics.hpp"
 #include "librarySPP.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <omp.h>
 
-std::tuple<char*, int, char*> GreedyRandomized(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
+void GreedyRandomized(
+    SolutionState& S,
     const float* U,
-    const float alpha) {
-  bool valid;
-  int i(0), j(0), k(0), s(0), e(0), min_u(n-1), max_u(0);
+    const float alpha,
+    const std::vector<int>* order,
+    Workspace* W) {
+  int n(S.n());
+  int j(0), e(0), rcl(0), min_u(0), max_u(0);
   float limit(0.0f);
-  std::vector<int> RCL;
-  char *x = new char[n], *column = new char[m];
-  for(i = 0; i < n; i++) x[i] = 0;
-  for(j = 0; j < m; j++) column[j] = 0;
-
-  std::vector<int> u_order = argsort(n, U); // DON'T FORGET TO DELETE
-
-  k = 0;
-  while(s != m && k < n) {
-    // Indices of max and min utilities
-    for(j = max_u, max_u = 0; j < n && u_order[max_u] == -1; j++)
-      max_u = j;
-    for(j = min_u, min_u = n-1; j >= 0 && u_order[min_u] == -1; j--)
-      min_u = j;
-    limit = U[u_order[min_u]] + alpha * (U[u_order[max_u]] - U[u_order[min_u]]);
-    for(j = 0; j < n; j++)
-      // If variable's index is candidate and the utility
-      // greater than limit then we add the index in RCL
-      if(u_order[j] != -1 && U[u_order[j]] >= limit)
-         RCL.push_back(j);
+  const ConstraintMatrix* A(S.matrix());
+  std::unique_ptr<Workspace> local;
+  if(!W) local = std::make_unique<Workspace>(n), W = local.get();
+  std::vector<int>& pos(W->pos);
+  Candidates& cand(W->cand);
+  S.reset();
+
+  std::vector<int> sorted;
+  if(!order) sorted = argsort(n, U), order = &sorted;
+  const std::vector<int>& u_order = *order;
+  // Position of each variable in the order
+  for(e = 0; e < n; e++) pos[u_order[e]] = e;
+  cand.reset();
+
+  // Every candidate left fits : the ones sharing a row with a selected
+  // variable are dropped as soon as it is selected
+  while(cand.size()) {
+    // Max and min utilities : first and last candidates in the order
+    max_u = u_order[cand.find(1)], min_u = u_order[cand.find(cand.size())];
+    limit = U[min_u] + alpha * (U[max_u] - U[min_u]);
+    // The utilities being sorted, the RCL is made of the candidates before
+    // the first position whose utility is lower than limit
+    rcl = cand.count(std::partition_point(u_order.begin(), u_order.end(),
+          [U, limit](int v) { return U[v] >= limit; }) - u_order.begin());
 
     // Select an element e from RCL at random
-    e = (RCL.size()) ? *select_randomly(RCL.begin(), RCL.end()) : max_u;
-    for(j = 0, valid = true; j < m && valid; j++)
-      valid = !(column[j] & A[INDEX(u_order[e], j)]);
-    for(j = 0, s = 0; valid && j < m; s += column[j], j++)
-      column[j] += A[INDEX(u_order[e], j)];
-    x[u_order[e]] = valid, u_order[e] = -1;
-    k += 1; RCL.clear();
+    e = cand.find(rcl ? 1 + random_index(rcl) : 1);
+    j = u_order[e];
+    S.insert(j), cand.erase(e);
+    if(A->conflicts.built()) {
+      for(const int *k = A->conflicts.neighbours(j),
+          *f = k + A->conflicts.degree(j); k != f; k++)
+        cand.erase(pos[*k]);
+    } else {
+      for(const int *r = A->rows(j), *f = r + A->nbRows(j); r != f; r++)
+        for(const int *k = A->vars(*r), *g = k + A->nbVars(*r); k != g; k++)
+          cand.erase(pos[*k]);
+    }
   }
+}
+
+void GreedyAdaptive(SolutionState& S, const float alpha, Workspace* W) {
+  int n(S.n());
+  int j(0), t(0), i(0), r(0), delta(0);
+  float limit(0.0f);
+  const int* C(S.costs());
+  const ConstraintMatrix* A(S.matrix());
+  std::unique_ptr<Workspace> local;
+  if(!W) local = std::make_unique<Workspace>(n, A), W = local.get();
+  m_assert((int)W->live.size() == A->m, "The workspace has no buffers for the rows");
+  // Number of candidates eliminated by each candidate (counted once per
+  // shared row, with the counts  snap  of its rows) and utility
+  std::vector<int> &conf(W->conf), &RCL(W->RCL), &dropped(W->dropped),
+    &touched(W->touched);
+  // Candidates left in each row ( live ), the count used in  conf  ( snap )
+  // and the copy of the row in  rowVar  whose  len  first variables hold
+  // every candidate left
+  std::vector<int> &live(W->live), &snap(W->snap), &len(W->len),
+    &rowVar(W->rowVar);
+  std::vector<float>& u(W->u);
+  std::vector<char>& seen(W->seen);
+  IndexedHeap<std::greater<float>>& hi(W->hi);
+  IndexedHeap<std::less<float>>& lo(W->lo);
+  S.reset();
+  hi.clear(), lo.clear();
+  std::fill(conf.begin(), conf.end(), 0);
+  std::copy(A->rowVar.begin(), A->rowVar.end(), rowVar.begin());
+  for(r = 0; r < A->m; r++) live[r] = snap[r] = len[r] = A->nbVars(r);
+
+  for(j = 0; j < n; j++) {
+    for(const int *k = A->rows(j), *e = k + A->nbRows(j); k != e; k++)
+      conf[j] += snap[*k] - 1;
+    u[j] = C[j] / (1.0f + conf[j]);
+    hi.push(j), lo.push(j);
+  }
+
+  while(hi.size()) {
+    limit = u[lo.top()] + alpha * (u[hi.top()] - u[lo.top()]);
+    // A few candidates drawn at random, the RCL is only listed (from the
+    // top of  hi , the candidates above  limit  forming a subtree) if none
+    // of them is in it : both give a member of the RCL uniformly
+    for(t = 0, j = -1; t < 8 && j == -1; t++)
+      if(u[i = hi.at(random_index(hi.size()))] >= limit) j = i;
+    if(j == -1) {
+      RCL.clear(), RCL.push_back(0);
+      for(t = 0; t < (int)RCL.size(); t++)
+        for(i = 2 * RCL[t] + 1; i <= 2 * RCL[t] + 2; i++)
+          if(i < hi.size() && u[hi.at(i)] >= limit) RCL.push_back(i);
+      j = hi.at(RCL[random_index(RCL.size())]);
+    }
+    S.insert(j);
 
-  return std::make_tuple(x, dot(n, x, C), column);
+    // j  and the candidates sharing a row with it leave the heaps (the rows
+    // of  j  are left with no candidate, they are only visited here)
+    dropped.clear(), dropped.push_back(j);
+    hi.erase(j), lo.erase(j);
+    for(const int *k = A->rows(j), *e = k + A->nbRows(j); k != e; k++)
+      for(const int *v = &rowVar[A->rowBeg[*k]], *f = v + len[*k]; v != f; v++)
+        if(hi.contains(*v)) dropped.push_back(*v), hi.erase(*v), lo.erase(*v);
+    for(int d : dropped)
+      for(const int *k = A->rows(d), *e = k + A->nbRows(d); k != e; k++)
+        live[*k]--;
+    // A row is counted again once its candidates are halved : it is
+    // compacted to them and their utility is updated, so each row is
+    // visited O(|row|) times in all and  snap  is at most twice  live
+    // (each candidate moved once in the heaps)
+    touched.clear();
+    for(int d : dropped)
+      for(const int *k = A->rows(d), *e = k + A->nbRows(d); k != e; k++) {
+        if(2 * live[*k] > snap[*k]) continue;
+        int *v(&rowVar[A->rowBeg[*k]]), *f(v + len[*k]), *o(v);
+        delta = live[*k] - snap[*k];
+        for(; v != f; v++)
+          if(hi.contains(*v)) {
+            *o++ = *v, conf[*v] += delta;
+            if(!seen[*v]) seen[*v] = 1, touched.push_back(*v);
+          }
+        len[*k] = o - &rowVar[A->rowBeg[*k]], snap[*k] = live[*k];
+      }
+    for(int k : touched) {
+      seen[k] = 0, u[k] = C[k] / (1.0f + conf[k]);
+      hi.update(k), lo.update(k);
+    }
+  }
 }
 
 void GreedyImprovement(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
+    SolutionState& S,
     bool deep,
-    char* column) {
-  int i(2);
-  bool (*f[3])(int, int, const int*, const char*, char*, int*, bool, char*) = {
-      zero_oneExchange,
-      one_oneExchange,
-      two_oneExchange
-    };
-
-  // We modify x and z directly (no copy)
-  while(i >= 0){
-    if(!f[i](m, n, C, A, x, z, deep, column)) i--;
+    const std::vector<Neighbourhood>& neighbourhoods,
+    bool queue) {
+  size_t i(0);
+  bool improved(true), p1(false);
+
+  // We modify S directly (no copy)
+  if(!queue) {
+    while(i < neighbourhoods.size()){
+      if(!exchange(S, neighbourhoods[i], deep)) i++;
+    }
+    return ;
+  }
+
+  for(Neighbourhood nb : neighbourhoods) p1 = p1 || nb.p == 1;
+  while(improved) {
+    if(p1) queueExchange(S, neighbourhoods, deep);
+    improved = false;
+    for(i = 0; i < neighbourhoods.size() && !improved; i++)
+      if(neighbourhoods[i].p != 1) improved = exchange(S, neighbourhoods[i], deep);
   }
 }
 
@@ -74,7 +170,7 @@ void ReactiveGRASP(
     const int m,
     const int n,
     const int* C,
-    const char* A,
+    const ConstraintMatrix* A,
     const float* U,
     std::vector<int>& zInits,
     std::vector<int>& zAmels,
@@ -85,20 +181,35 @@ void ReactiveGRASP(
     const double delta,
     int nbIter,
     bool deep,
-    bool parallel) {
+    bool parallel,
+    const std::vector<Neighbourhood>& neighbourhoods,
+    bool queue,
+    bool adaptive) {
   int iter(0), zBest(-1), chunkLeft(probaUpdate), upd(0);
   double mean(0.0), diff(0.0), frac(0.0), sum(0.0), zmax(0.0), zmin(0.0);
   std::vector<std::vector<int>> pool(alpha.size(), std::vector<int>(probaUpdate));
   std::vector<double> valuation(pool.size(), 0.0);
   std::vector<int> poolData_i(probaUpdate, 0);
   std::vector<int> poolData_z(probaUpdate, 0);
+  // One solution and one workspace per thread, reused by all its iterations
+  const int nbThreads(parallel ? omp_get_max_threads() : 1);
+  std::vector<std::unique_ptr<SolutionState>> states(nbThreads);
+  std::vector<std::unique_ptr<Workspace>> spaces(nbThreads);
+  for(int t = 0; t < nbThreads; t++)
+    states[t] = std::make_unique<SolutionState>(m, n, C, A),
+    spaces[t] = std::make_unique<Workspace>(n, adaptive ? A : nullptr);
+  // A pool gets at most every value of  z  (no reallocation while running)
+  for(auto& e : pool) e.reserve(probaUpdate + nbIter);
+  // The utilities don't change : they are sorted once for all the iterations
+  const std::vector<int> order = adaptive ? std::vector<int>() : argsort(n, U);
 
   for(iter = 0; iter < nbIter; iter += chunkLeft) {
     if(iter + chunkLeft > nbIter) chunkLeft = nbIter-iter;
 
     #pragma omp parallel for if(parallel)
     for(upd = iter; upd < iter+chunkLeft; upd++) {
-      char *x(nullptr), *column(nullptr);
+      SolutionState& S(*states[omp_get_thread_num()]);
+      Workspace* W(spaces[omp_get_thread_num()].get());
       int i(0);
       float sel_alpha(-1.0), idx((double)rand() / RAND_MAX), s(0);
       for(i = 0; i < (int)proba.size() && sel_alpha == -1.0; i++) {
@@ -110,17 +221,14 @@ void ReactiveGRASP(
         i = rand() % alpha.size(); // case
         sel_alpha = alpha[i];
       }
-      std::tie(x, zInits[upd], column) = GreedyRandomized(m, n, C, A, U, sel_alpha);
-      zAmels[upd] = zInits[upd];
-      GreedyImprovement(m, n, C, A,
-          x, &zAmels[upd], deep, column);
+      if(adaptive) GreedyAdaptive(S, sel_alpha, W);
+      else         GreedyRandomized(S, U, sel_alpha, &order, W);
+      zInits[upd] = S.z();
+      GreedyImprovement(S, deep, neighbourhoods, queue);
+      zAmels[upd] = S.z();
       // Pool data (will help to reconstruct the pool after the parallel for)
       poolData_i[upd-iter] = i;
       poolData_z[upd-iter] = zAmels[upd];
-
-      /* MOST IMPORTANT SECTION */
-      if(x) delete[] x, x = nullptr;
-      if(column) delete[] column, column = nullptr;
     }
 
     // Reconstruct pool
@@ -141,8 +249,6 @@ void ReactiveGRASP(
 
     for(upd = 0; upd < (int)proba.size(); upd++)
       proba[upd] = sum ? valuation[upd]/sum : proba[upd];
-
-    for(auto e : pool) e.clear(); // Clear each pool
   }
 
 
@@ -1,5 +1,12 @@
 #include "librarySPP.hpp"
 
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 std::vector<std::string> getfname(std::string pathtofolder) {
   std::vector<std::string> files;
   // Get all files from folder
@@ -26,85 +33,353 @@ std::vector<std::string> getfname(std::string pathtofolder) {
   return files;
 }
 
-std::tuple<int, int, std::unique_ptr<int[]>, std::unique_ptr<char[]>, std::unique_ptr<float[]>> loadSPP(std::string fname)
-{
-  std::ifstream f(fname);
-  std::string line("");
-  std::stringstream ss("");
-  int m(-1), n(-1), i(0), j(0);
-  std::unique_ptr<int[]> C;
-  std::unique_ptr<char[]> A;
-  std::unique_ptr<float[]> U;
+size_t ConstraintMatrix::memory() const {
+  return sizeof(ConstraintMatrix)
+    + (colBeg.capacity() + rowBeg.capacity()) * sizeof(nnz_t)
+    + (colRow.capacity() + rowVar.capacity()) * sizeof(int)
+    + conflicts.memory();
+}
 
-  try {
-    if(f.is_open()) {
-      // Read m (number of constraints) and n (number of variables)
-      f >> m >> n; f.ignore();
-      // Creates C, U and A. Init U and A elements to zero.
-      C = std::make_unique<int[]>(n), U = std::make_unique<float[]>(n), A = std::make_unique<char[]>(n*m);
-      for(i = 0; i < n*m; i++) { A[i] = 0; if(i < n) U[i] = 0; }
-      // Read the n coefficiens of the objective function and init C
-      getline(f, line); ss.str(line); ss.clear(); while(j < n && ss >> C[j++]);
-      // Read the m constraints and reconstruct matrix A
-      for(j = 0, i = 0; j < m; j++){
-        // Read number of not null elements on constraint i (not used)
-        getline(f, line);
-        // Read indices of not null elements on constraint i
-        getline(f, line); ss.str(line); ss.clear();
-        while(ss >> i)
-          if(i > 0 && i <= n)
-            A[INDEX(i-1, j)] = 1, U[i-1] += 1;
+void ConstraintMatrix::buildColumns() {
+  int i(0), j(0);
+  nnz_t k(0);
+  nnz = rowVar.size();
+  colBeg.assign(n+1, 0), colRow.resize(nnz);
+  for(int v : rowVar) colBeg[v+1]++;
+  for(j = 0; j < n; j++) colBeg[j+1] += colBeg[j];
+  // Rows are visited in increasing order so each column ends up sorted
+  std::vector<nnz_t> fill(colBeg.begin(), colBeg.end()-1);
+  for(i = 0; i < m; i++)
+    for(k = rowBeg[i]; k < rowBeg[i+1]; k++)
+      colRow[fill[rowVar[k]]++] = i;
+}
+
+void ConstraintMatrix::buildConflicts(bool parallel) {
+  ConflictGraph& G(conflicts);
+  G.n = n, G.adjBeg.assign(n+1, 0), G.adj.clear(), G.matrix.clear();
+
+  // Two passes over the neighbourhoods : count the degrees, then fill
+  // the lists. Each thread marks the neighbours already met in  mark .
+  // An exception can't leave the parallel region : it is thrown again after
+  std::exception_ptr error;
+  for(int pass = 0; pass < 2 && !error; pass++) {
+    #pragma omp parallel if(parallel)
+    {
+      std::vector<int> mark;
+      try {
+        mark.assign(n, -1);
+      } catch(...) {
+        #pragma omp critical
+        error = std::current_exception();
       }
-      f.close();
-    } else throw std::runtime_error("Couldn't open file " + fname);
-  } catch(std::exception const& e) {
-    std::cerr << "ERROR: " << e.what() << std::endl;
+      #pragma omp for schedule(dynamic, 64)
+      for(int j = 0; j < n; j++) {
+        if(mark.empty()) continue;
+        nnz_t d(pass ? G.adjBeg[j] : 0);
+        mark[j] = j;
+        for(const int *r = rows(j), *e = r + nbRows(j); r != e; r++)
+          for(const int *k = vars(*r), *f = k + nbVars(*r); k != f; k++)
+            if(mark[*k] != j) {
+              mark[*k] = j;
+              if(pass) G.adj[d] = *k;
+              d++;
+            }
+        if(pass) std::sort(G.adj.begin() + G.adjBeg[j], G.adj.begin() + d);
+        else G.adjBeg[j+1] = d;
+      }
+    }
+    if(!pass && !error) {
+      for(int j = 0; j < n; j++) G.adjBeg[j+1] += G.adjBeg[j];
+      G.adj.resize(G.adjBeg[n]);
+    }
   }
+  if(error) std::rethrow_exception(error);
 
-  for(i = 0; i < n; i++) U[i] = C[i]/U[i];
-  return std::make_tuple(m, n, std::move(C), std::move(A), std::move(U));
+  // The adjacency matrix is kept if it isn't bigger than the lists
+  G.words = (n + 63) / 64;
+  if((size_t)n * G.words * sizeof(uint64_t) <= G.adj.size() * sizeof(int)) {
+    G.matrix.assign((size_t)n * G.words, 0);
+    #pragma omp parallel for if(parallel)
+    for(int j = 0; j < n; j++)
+      for(int k = 0; k < G.degree(j); k++)
+        G.matrix[(size_t)j * G.words + G.neighbours(j)[k] / 64] |=
+          uint64_t(1) << (G.neighbours(j)[k] % 64);
+  }
 }
 
-void modelSPP(
-    std::string instance,
-    std::string path,
-    float* tt,
-    bool verbose) {
-  int z(-1), m(-1), n(-1), ne(0), j(0), i(0);
-  int *C(nullptr), *ia(nullptr), *ja(nullptr);
-  double t(0.f), *ar(nullptr); INIT_TIMER();
-  std::ifstream f(path + instance);
-  std::string line("");
-  std::stringstream ss("");
-
-  /* Load data */
-  try {
-    if(f.is_open()) {
-      // Read m (number of constraints) and n (number of variables)
-      f >> m >> n; f.ignore();
-      // Creates C, U and A. Init U and A elements to zero.
-      C = new int[n], ia = new int[1+n*m], ja = new int[1+n*m];
-      ar = new double[1+m*n];
-      // Read the n coefficiens of the objective function and init C
-      getline(f, line); ss.str(line); ss.clear(); while(ss >> C[i++]);
-      // Read the m constraints and reconstruct matrix A
-      for(i = 1; i < m+1; i++){
-        // Read number of not null elements on constraint i (not used)
-        getline(f, line);
-        // Read indices of not null elements on constraint i
-        getline(f, line); ss.str(line); ss.clear();
-        while(ss >> j) {
-          ia[ne+1] = i, ja[ne+1] = j, ar[ne+1] = 1;
-          ne += 1;
+// Read-only memory mapping of a whole file
+class MappedFile {
+  public:
+    MappedFile(const std::string& fname) {
+      struct stat st;
+      int fd = open(fname.c_str(), O_RDONLY);
+      if(fd == -1 || fstat(fd, &st) == -1) {
+        if(fd != -1) close(fd);
+        throw std::runtime_error("Couldn't open file " + fname);
+      }
+      size = st.st_size;
+      if(size) {
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED) {
+          close(fd);
+          throw std::runtime_error("Couldn't map file " + fname);
         }
+        data = (const char*)p;
+        // The file is read once from start to end
+        madvise(p, size, MADV_SEQUENTIAL);
       }
-      f.close();
+      close(fd);
+    }
+    ~MappedFile() { if(data) munmap((void*)data, size); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+// Parses the integer following  p  (skipping blanks) into  v  and moves  p
+// right after it. Returns false if no integer is found before  end .
+static inline bool nextInt(const char*& p, const char* end, int& v) {
+  while(p != end && (unsigned char)*p <= ' ') p++;
+  auto [q, ec] = std::from_chars(p, end, v);
+  p = q;
+  return ec == std::errc();
+}
+
+std::tuple<std::unique_ptr<int[]>, std::unique_ptr<ConstraintMatrix>> parseSPP(std::string fname)
+{
+  MappedFile f(fname);
+  const char *p(f.data), *end(f.data + f.size);
+  int m(-1), n(-1), i(0), j(0), k(0), v(0);
+  std::unique_ptr<int[]> C;
+  std::unique_ptr<ConstraintMatrix> A = std::make_unique<ConstraintMatrix>();
+
+  // Read m (number of constraints) and n (number of variables)
+  if(!nextInt(p, end, m) || !nextInt(p, end, n) || m < 0 || n < 0)
+    throw std::runtime_error("Bad header in file " + fname);
+  A->m = m, A->n = n;
+  // Read the n coefficiens of the objective function and init C
+  C = std::make_unique<int[]>(n);
+  for(j = 0; j < n; j++)
+    if(!nextInt(p, end, C[j]))
+      throw std::runtime_error("Missing costs in file " + fname);
+  // Read the m constraints : the number of not null elements  k  followed
+  // by their indices, and build the rows of A (CSR)
+  A->rowBeg.reserve(m+1); A->rowBeg.push_back(0);
+  for(i = 0; i < m; i++) {
+    if(!nextInt(p, end, k))
+      throw std::runtime_error("Missing constraints in file " + fname);
+    for(j = 0; j < k; j++) {
+      if(!nextInt(p, end, v))
+        throw std::runtime_error("Truncated constraint in file " + fname);
+      if(v > 0 && v <= n) A->rowVar.push_back(v-1);
     }
+    // Sort the row if needed and drop duplicated indices
+    auto first = A->rowVar.begin() + A->rowBeg.back();
+    if(!std::is_sorted(first, A->rowVar.end()))
+      std::sort(first, A->rowVar.end());
+    A->rowVar.erase(std::unique(first, A->rowVar.end()), A->rowVar.end());
+    A->rowBeg.push_back(A->rowVar.size());
+  }
+
+  A->buildColumns();
+  return std::make_tuple(std::move(C), std::move(A));
+}
+
+// Header of the binary cache of an instance. It is followed by the arrays
+// C, U, rowBeg, rowVar, colBeg and colRow, each one starting on a  _PAD_
+// bytes boundary (see cacheOffsets).
+struct CacheHeader {
+  char magic[8];          // "SPPCACHE"
+  uint32_t version;       // _CACHE_VERSION_
+  int32_t m, n;
+  int64_t nnz;
+  uint64_t srcSize;       // size of the source file
+  int64_t srcMtime;       // last modification time of the source file
+  uint64_t srcChecksum;   // FNV-1a hash of the source file
+};
+
+// Bump when the layout of the cache changes (old caches are then rebuilt)
+#define _CACHE_VERSION_ 2
+
+// Sizes (in bytes) of the arrays stored in a cache
+static void cacheSizes(int m, int n, nnz_t nnz, size_t* sizes) {
+  sizes[0] = n * sizeof(int), sizes[1] = n * sizeof(float);
+  sizes[2] = (m+1) * sizeof(nnz_t), sizes[3] = nnz * sizeof(int);
+  sizes[4] = (n+1) * sizeof(nnz_t), sizes[5] = nnz * sizeof(int);
+}
+
+// Offsets (in bytes) of the arrays stored in a cache, the last element
+// being the size of the whole cache
+static std::vector<size_t> cacheOffsets(int m, int n, nnz_t nnz) {
+  size_t sizes[6];
+  std::vector<size_t> off(7, sizeof(CacheHeader));
+  cacheSizes(m, n, nnz, sizes);
+  for(int i = 0; i < 7; i++) {
+    off[i] = (off[i] + _PAD_ - 1) / _PAD_ * _PAD_;
+    if(i < 6) off[i+1] = off[i] + sizes[i];
+  }
+  return off;
+}
+
+// 64-bit FNV-1a hash of the content of  fname
+static uint64_t checksum(const std::string& fname) {
+  MappedFile f(fname);
+  uint64_t h(14695981039346656037ULL);
+  for(size_t i = 0; i < f.size; i++)
+    h = (h ^ (unsigned char)f.data[i]) * 1099511628211ULL;
+  return h;
+}
+
+std::string cacheName(std::string fname) {
+  std::filesystem::path p(fname);
+  return (p.parent_path() / ("." + p.filename().string() + ".bin")).string();
+}
+
+// Copies the  count  elements of the  a -th array of the cache  f
+template<typename T>
+static std::vector<T> cacheArray(
+    const MappedFile& f,
+    const std::vector<size_t>& off,
+    int a,
+    nnz_t count) {
+  const T* p = (const T*)(f.data + off[a]);
+  return std::vector<T>(p, p + count);
+}
+
+// Reads the cache of  fname  into  C ,  A  and  U . Returns false (and
+// leaves them untouched) if there is no cache or if it is outdated :
+//  * the version of the cache or the size of  fname  differ
+//  * the modification time of  fname  differs and so does its checksum
+// (if only the modification time differs, it is rewritten in the cache)
+static bool readCache(
+    const std::string& fname,
+    std::unique_ptr<int[]>& C,
+    std::unique_ptr<ConstraintMatrix>& A,
+    std::unique_ptr<float[]>& U) {
+  std::error_code ec;
+  std::string cname(cacheName(fname));
+  if(!std::filesystem::exists(cname, ec)) return false;
+
+  MappedFile f(cname);
+  CacheHeader h;
+  if(f.size < sizeof(CacheHeader)) return false;
+  std::memcpy(&h, f.data, sizeof(CacheHeader));
+  if(std::memcmp(h.magic, "SPPCACHE", 8) || h.version != _CACHE_VERSION_
+      || h.m < 0 || h.n < 0 || h.nnz < 0
+      || h.srcSize != std::filesystem::file_size(fname))
+    return false;
+  // Same content with another modification time (e.g. a copy) : the time
+  // is updated in the cache so that the next loads don't hash  fname  again
+  int64_t mtime(std::filesystem::last_write_time(fname).time_since_epoch().count());
+  bool touched(h.srcMtime != mtime);
+  if(touched && h.srcChecksum != checksum(fname))
+    return false;
+  std::vector<size_t> off(cacheOffsets(h.m, h.n, h.nnz));
+  if(f.size < off[6]) return false;
+
+  C = std::make_unique<int[]>(h.n), U = std::make_unique<float[]>(h.n);
+  std::memcpy(C.get(), f.data + off[0], h.n * sizeof(int));
+  std::memcpy(U.get(), f.data + off[1], h.n * sizeof(float));
+  A = std::make_unique<ConstraintMatrix>();
+  A->m = h.m, A->n = h.n, A->nnz = h.nnz;
+  A->rowBeg = cacheArray<nnz_t>(f, off, 2, h.m+1);
+  A->rowVar = cacheArray<int>(f, off, 3, h.nnz);
+  A->colBeg = cacheArray<nnz_t>(f, off, 4, h.n+1);
+  A->colRow = cacheArray<int>(f, off, 5, h.nnz);
+  if(touched) {
+    h.srcMtime = mtime;
+    std::fstream out(cname, std::ios::binary | std::ios::in | std::ios::out);
+    out.write((const char*)&h, sizeof(CacheHeader));
+  }
+  return true;
+}
+
+// Writes the cache of  fname  (through a temporary file renamed once
+// complete). Failing to write the cache is not an error.
+static void writeCache(
+    const std::string& fname,
+    const int* C,
+    const ConstraintMatrix& A,
+    const float* U) {
+  std::error_code ec;
+  std::string cname(cacheName(fname)), tmp(cname + ".tmp");
+  std::vector<size_t> off(cacheOffsets(A.m, A.n, A.nnz));
+  const char* arrays[6] = {
+    (const char*)C, (const char*)U,
+    (const char*)A.rowBeg.data(), (const char*)A.rowVar.data(),
+    (const char*)A.colBeg.data(), (const char*)A.colRow.data()
+  };
+  CacheHeader h;
+  std::memcpy(h.magic, "SPPCACHE", 8);
+  h.version = _CACHE_VERSION_, h.m = A.m, h.n = A.n, h.nnz = A.nnz;
+  h.srcSize = std::filesystem::file_size(fname, ec);
+  h.srcMtime = std::filesystem::last_write_time(fname, ec).time_since_epoch().count();
+  h.srcChecksum = checksum(fname);
+  if(ec) return;
+
+  size_t sizes[6], pos(sizeof(CacheHeader));
+  cacheSizes(A.m, A.n, A.nnz, sizes);
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  std::vector<char> pad(_PAD_, 0);
+  f.write((const char*)&h, sizeof(CacheHeader));
+  for(int i = 0; i < 7 && f; i++) {
+    // Pad up to the next array (or to the end of the cache)
+    f.write(pad.data(), off[i] - pos);
+    if(i < 6) f.write(arrays[i], sizes[i]), pos = off[i] + sizes[i];
+  }
+  f.close();
+  if(f) std::filesystem::rename(tmp, cname, ec);
+  else std::filesystem::remove(tmp, ec);
+}
+
+std::tuple<int, int, std::unique_ptr<int[]>, std::unique_ptr<ConstraintMatrix>, std::unique_ptr<float[]>> loadSPP(
+    std::string fname,
+    bool cache,
+    bool conflicts,
+    float* tParse)
+{
+  int m(-1), n(-1), i(0);
+  float t(0.f); INIT_TIMER();
+  std::unique_ptr<int[]> C;
+  std::unique_ptr<ConstraintMatrix> A;
+  std::unique_ptr<float[]> U;
+
+  try {
+    if(!cache || !readCache(fname, C, A, U)) {
+      TIMED(t, std::tie(C, A) = parseSPP(fname));
+      U = std::make_unique<float[]>(A->n);
+      for(i = 0; i < A->n; i++) U[i] = C[i]/(float)A->nbRows(i);
+      if(cache) writeCache(fname, C.get(), *A, U.get());
+    }
+    m = A->m, n = A->n;
   } catch(std::exception const& e) {
     std::cerr << "ERROR: " << e.what() << std::endl;
+    A = std::make_unique<ConstraintMatrix>();
+    A->colBeg.push_back(0), A->rowBeg.push_back(0);
   }
 
-  m_print(std::cout, _CLB, "\nInstance : ", instance, "\n\n", _CLR);
+  if(conflicts) A->buildConflicts();
+  if(tParse) *tParse = t;
+  return std::make_tuple(m, n, std::move(C), std::move(A), std::move(U));
+}
+
+// Creates the GLPK model of the SPP of objective  C  and constraints  A .
+// The triplets (row, column, 1) given to GLPK only hold the  nnz  non-zero
+// elements of  A .
+static glp_prob* buildModel(const int* C, const ConstraintMatrix& A) {
+  int i(0);
+  nnz_t j(0), k(0);
+  // GLPK indexes the non-zero elements with  int
+  if(A.nnz > INT_MAX - 1)
+    throw std::runtime_error("Too many non-zero elements for GLPK");
+  std::vector<int> ia(1+A.nnz), ja(1+A.nnz);
+  std::vector<double> ar(1+A.nnz, 1.0);
+
+  for(i = 0, k = 1; i < A.m; i++)
+    for(j = A.rowBeg[i]; j < A.rowBeg[i+1]; j++, k++)
+      ia[k] = i+1, ja[k] = A.rowVar[j]+1;
 
   /* Create problem */
   glp_prob *lp = glp_create_prob();
@@ -112,21 +387,48 @@ void modelSPP(
   glp_set_obj_dir(lp, GLP_MAX);
 
   /* Model SPP */
-  glp_add_rows(lp, m);
-  for(i = 1; i < m+1; i++) {
+  // Since x >= 0, each packing constraint only needs an upper bound
+  glp_add_rows(lp, A.m);
+  for(i = 1; i < A.m+1; i++) {
     glp_set_row_name(lp, i, std::to_string(i).c_str());
-    glp_set_row_bnds(lp, i, GLP_DB, 0, 1);
+    glp_set_row_bnds(lp, i, GLP_UP, 0, 1);
+  }
+
+  glp_add_cols(lp, A.n);
+  for(i = 1; i < A.n+1; i++) {
+    glp_set_col_kind(lp, i, GLP_IV);
+    glp_set_obj_coef(lp, i, C[i-1]);
+    glp_set_col_name(lp, i, std::string("x" + std::to_string(i)).c_str());
+    glp_set_col_bnds(lp, i, GLP_DB, 0, 1);
   }
 
-  glp_add_cols(lp, n);
-  for(j = 1; j < n+1; j++) {
-    glp_set_col_kind(lp, j, GLP_IV);
-    glp_set_obj_coef(lp, j, C[j-1]);
-    glp_set_col_name(lp, j, std::string("x" + std::to_string(j)).c_str());
-    glp_set_col_bnds(lp, j, GLP_DB, 0, 1);
+  glp_load_matrix(lp, (int)A.nnz, ia.data(), ja.data(), ar.data());
+  return lp;
+}
+
+void modelSPP(
+    std::string instance,
+    std::string path,
+    float* tt,
+    bool verbose) {
+  int z(-1);
+  float t(0.f), tb(0.f); INIT_TIMER();
+  std::unique_ptr<int[]> C;
+  std::unique_ptr<ConstraintMatrix> A;
+  glp_prob *lp(nullptr);
+
+  /* Load data and build the model */
+  try {
+    std::tie(C, A) = parseSPP(path + instance);
+    m_print(std::cout, _CLB, "\nInstance : ", instance, "\n\n", _CLR);
+    TIMED(tb, lp = buildModel(C.get(), *A));
+  } catch(std::exception const& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return ;
   }
 
-  glp_load_matrix(lp, ne, ia, ja, ar);
+  m_print(std::cout, "Modèle construit en ", tb, " secondes (", A->nnz,
+      " éléments non nuls).\n");
 
   /* Solve with simplex with presolve and time limit */
   glp_iocp parm;
@@ -135,39 +437,35 @@ void modelSPP(
   parm.presolve = GLP_ON;
   parm.tm_lim = 180000; // 180s time limit
 
-  TIMED(t, glp_intopt(lp, &parm)); (*tt) += t;
+  TIMED(t, glp_intopt(lp, &parm)); if(tt) (*tt) += t;
   z = glp_mip_obj_val(lp);
   m_print(std::cout, _CLG, "Résolue en ", t, " secondes. z_opt = ", z, "\n", _CLR);
 
-  /* Free problem and arrays */
+  /* Free problem */
   glp_delete_prob(lp);
-  delete[] C; delete[] ia; delete[] ja; delete[] ar;
 }
 
 bool isFeasible(
     int m,
     int n,
     const int *C,
-    const char *A,
+    const ConstraintMatrix *A,
     const char *x,
-    const char* extColumn,
     bool verbose) {
   bool feasible = true;
-  int i(0), j(0), z(0), sum_xi(0);
-  char *column(nullptr);
-  if(!extColumn) {
-    column = new char[m];
-    for(j = 0; j < m; j++) column[j] = 0;
-  } else column = (char*)extColumn;
+  int i(0), z(0), sum_xi(0);
+  nnz_t k(0);
+  std::vector<char> column(m, 0);
 
   for(i = 0; i < n && feasible; i++) {
     // If variable i is selected then we add the i-th column of
-    // matrix A to the variable column
-    for(j = 0; x[i] && j < m && feasible; j++) {
-      if(!extColumn) column[j] += A[INDEX(i, j)];
+    // matrix A to the variable column (only its non-zero elements)
+    for(k = A->colBeg[i]; x[i] && k < A->colBeg[i+1] && feasible; k++) {
+      column[A->colRow[k]] += 1;
       // If an element of column is strictly greater than 1 then the
       // constraints are violated and x is not feasible
-      feasible = feasible && column[j] >= 0 && column[j] <= 1;
+      feasible = feasible && column[A->colRow[k]] >= 0
+                          && column[A->colRow[k]] <= 1;
     }
     sum_xi += x[i], z += x[i] * C[i];
   }
@@ -177,6 +475,5 @@ bool isFeasible(
     m_print(std::cout, _CLG, "Feasible : yes | Σ(x_i) = ", sum_xi, " ; z(x) = ", z, "\n", _CLR);
   }
 
-  if(!extColumn) delete[] column;
   return feasible;
 }
@@ -1,4 +1,5 @@
 #include "plots.hpp"
+#include "pipeline.hpp"
 #include "heuristics.hpp"
 
 #include <omp.h>
@@ -19,6 +20,16 @@
 #define PROBA_UPDATE  50
 #define NUM_DIVISION  20
 #define DEEPSEARCH    true
+#define NEIGHBOURHOODS {{2, 1}, {1, 1}, {0, 1}}
+#define QUEUE_LS      false
+#define ADAPTIVE      false
+#define CACHE         true
+#define CONFLICTS     false
+#define PRESOLVE      true
+
+// Paramètres pipeline
+#define PIPELINE      true
+#define PREFETCH_MB   512
 
 // Paramètres plot
 #define INTERACTIVE   false
@@ -52,6 +63,18 @@ int main() {
     if(PARALLEL) omp_set_num_threads(MAX_THREADS);
     const std::vector<double> alpha(ALPHA);
     m_assert(alpha.size(), "Erreur : aucune valeur de alpha!");
+    const std::vector<Neighbourhood> neighbourhoods(NEIGHBOURHOODS);
+    for(auto nb : neighbourhoods)
+      m_assert((nb.p == 1 || nb.p == 2) && nb.k <= _MOVE_MAX_ && nb.k + 1 >= nb.p,
+               "Erreur : voisinage non supporté!");
+    // The queue replaces exactly the  k  blockers of a variable : it only
+    // explores the (k,1)-exchanges listed if the smaller ones are listed too
+    if(QUEUE_LS)
+      for(auto nb : neighbourhoods)
+        for(int k = 0; nb.p == 1 && k < nb.k; k++)
+          m_assert(std::any_of(neighbourhoods.begin(), neighbourhoods.end(),
+                     [k](Neighbourhood o) { return o.p == 1 && o.k == k; }),
+                   "Erreur : avec la file, (k,1) demande les voisinages (k',1) pour k' < k!");
 
     const int _NBD_ = NUM_DIVISION > NUM_ITER ? NUM_ITER : NUM_DIVISION;
     const int _NBU_ = PROBA_UPDATE > NUM_ITER ? ceil(NUM_ITER/10.0) : PROBA_UPDATE;
@@ -65,6 +88,16 @@ int main() {
     if(PARALLEL)
       m_print(std::cout, "\nnombre de threads\t: ", MAX_THREADS);
     m_print(std::cout, "\ndescente profonde\t: ", (DEEPSEARCH ? "oui" : "non"));
+    m_print(std::cout, "\nvoisinages\t\t: ");
+    for(auto nb : neighbourhoods) m_print(std::cout, nb.k, "-", nb.p, " ");
+    m_print(std::cout, "\nfile de variables\t: ", (QUEUE_LS ? "oui" : "non"));
+    m_print(std::cout, "\nutilité adaptative\t: ", (ADAPTIVE ? "oui" : "non"));
+    m_print(std::cout, "\ncache binaire\t\t: ", (CACHE ? "oui" : "non"));
+    m_print(std::cout, "\ngraphe de conflits\t: ", (CONFLICTS ? "oui" : "non"));
+    m_print(std::cout, "\nprésolution\t\t: ", (PRESOLVE ? "oui" : "non"));
+    m_print(std::cout, "\npipeline\t\t: ", (PIPELINE ? "oui" : "non"));
+    if(PIPELINE)
+      m_print(std::cout, "\nmémoire préchargement\t: ", PREFETCH_MB, " Mo");
     m_print(std::cout, "\nplot des runs en \t: ", _NBD_, " points");
     if(std::string("").compare(PATH_PLOT))
       m_print(std::cout, "\nrépertoire plots \t: ", PATH_PLOT);
@@ -74,7 +107,7 @@ int main() {
     float t(0);
     int ins(0), run(0), div(0), m(-1), n(-1);
     std::unique_ptr<int[]> C;
-    std::unique_ptr<char[]> A;
+    std::unique_ptr<ConstraintMatrix> A;
     std::unique_ptr<float[]> U;
     std::vector<int> zInits(NUM_ITER, 0),
              zAmels(NUM_ITER, 0),
@@ -90,6 +123,14 @@ int main() {
   #endif
 
   std::vector<std::string> fnames = getfname(path);
+  #if !USE_GLPK
+    // Instance k+1 (and the next ones if they fit in PREFETCH_MB) is loaded
+    // while instance k is solved, and the plots of instance k are drawn
+    // while instance k+1 is solved
+    InstancePrefetcher loader(path, fnames, CACHE, CONFLICTS, PRESOLVE,
+        (size_t)PREFETCH_MB << 20, PIPELINE);
+    TaskQueue plots(PIPELINE);
+  #endif
   for(auto instance : fnames) {
     #if USE_GLPK
       modelSPP(instance, path, &tt, VERBOSE_GLPK);
@@ -106,17 +147,41 @@ int main() {
       }
       std::vector<double> proba = std::vector<double>(alpha.size(), 1.0/alpha.size());
 
-      // Load one numerical instance
-      std::tie(m, n, C, A, U) = loadSPP(path + instance);
+      // Get one numerical instance
+      LoadedInstance li(loader.next());
+      m = li.m, n = li.n, t = li.t;
+      C = std::move(li.C), A = std::move(li.A), U = std::move(li.U);
       m_print(std::cout, _CLB, "\nInstance : ", instance, "\n", _CLR);
+      m_print(std::cout, "Chargée en ", t, "s");
+      // Throughput of the parser only (not of the cache)
+      if(li.tParse > 0)
+        m_print(std::cout, " (lecture ", li.tParse, "s, ",
+            std::filesystem::file_size(path + instance) / (1e6 * li.tParse),
+            " Mo/s)\n");
+      else
+        m_print(std::cout, " (depuis le cache)\n");
+      if(PRESOLVE && li.P.n > 0)
+        m_print(std::cout, "Présolution en ", li.tp, "s : ",
+            li.P.n - n, "/", li.P.n, " variables (", li.P.fixedCols, " fixées, ",
+            li.P.dominatedCols, " dominées) et ", li.P.m - m, "/", li.P.m,
+            " contraintes supprimées\n");
+      if(A->conflicts.built())
+        m_print(std::cout, "Graphe de conflits : ", A->conflicts.adj.size() / 2,
+            " arêtes, ", A->conflicts.memory() / 1e6, " Mo",
+            (A->conflicts.matrix.empty() ? "" : " (avec matrice d'adjacence)"), "\n");
 
       m_print(std::cout, "Run exécutés :");
       for(run = 0; run < NUM_RUN; run++) {
         // Run ReactiveGRASP NUM_RUN times
         TIMED(t,
           ReactiveGRASP(m, n, C.get(), A.get(), U.get(), zInits, zAmels, zBests,
-            alpha, proba, _NBU_, DELTA, NUM_ITER, DEEPSEARCH, PARALLEL);
+            alpha, proba, _NBU_, DELTA, NUM_ITER, DEEPSEARCH, PARALLEL,
+            neighbourhoods, QUEUE_LS, ADAPTIVE);
         );
+        // Values of z in the original instance
+        if(PRESOLVE)
+          for(auto zs : {&zInits, &zAmels, &zBests})
+            for(int& z : *zs) z = li.P.restore(z);
         tMoy[ins] = (!run) ? t : tMoy[ins]+t;
         // Compute zMax, zMin and zMoy NUM_DIVISION time
         for(div = 0; div < _NBD_; div++) {
@@ -136,14 +201,16 @@ int main() {
       allrunzmoy /= (double)NUM_RUN;
       for(div = 0; div < _NBD_; div++) zMoy[div] /= (double)NUM_RUN;
 
-      // Plots
+      // Plots (on copies of the results since the next instance reuses them)
       m_print(std::cout, "\nPlot du dernier run...\n");
-      plotRunGRASP(instance, zInits, zAmels, zBests, PATH_PLOT, SILENT_MODE);
       m_print(std::cout, "Plot des probabilités des α pour le dernier run...\n");
-      plotProbaRunGRASP(instance, alpha, proba, PATH_PLOT, SILENT_MODE);
       m_print(std::cout, "Bilan de l'ensemble des runs...\n");
-      plotAnalyseGRASP(instance, divs, zMin, zMoy, zMax, allrunzmin, allrunzmoy,
-          allrunzmax, PATH_PLOT, SILENT_MODE);
+      plots.push([=]() {
+        plotRunGRASP(instance, zInits, zAmels, zBests, PATH_PLOT, SILENT_MODE);
+        plotProbaRunGRASP(instance, alpha, proba, PATH_PLOT, SILENT_MODE);
+        plotAnalyseGRASP(instance, divs, zMin, zMoy, zMax, allrunzmin, allrunzmoy,
+            allrunzmax, PATH_PLOT, SILENT_MODE);
+      });
 
       ins++;
     #endif
@@ -158,6 +225,7 @@ int main() {
 
     // Plots
     m_print(std::cout, "\n\nBilan CPUt moyen (par run) pour chaque instance...\n");
+    plots.wait();
     plotCPUt(fnames, tMoy, PATH_PLOT, SILENT_MODE);
 
     if(INTERACTIVE) {
@@ -1,185 +1,219 @@
 #include "movements.hpp"
 
 bool zero_oneExchange(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column) {
-  int c(-1), tmp_z(-1), best_z(*z), best_move(-1);
-  std::forward_list<int> idx0 = findItems<char>(n, x, 0);
-
-  for(int i : idx0) {
-    x[i] = 1; tmp_z = *z + C[i];
-    if(tmp_z > best_z) {
-      for(c = 0; c < m && column; c++) column[c] += A[INDEX(i, c)];
-      if(isFeasible(m, n, C, A, x, column, false)) {
-        if(deep) {
-          best_z = tmp_z; best_move = i;
-        }
-        else return (*z = tmp_z);
-      }
-      for(c = 0; c < m && column; c++) column[c] -= A[INDEX(i, c)];
+    SolutionState& S,
+    bool deep) {
+  // The best insertion is the free variable with the greatest cost (also
+  // used without  deep  since it is found as fast as any other)
+  int j(S.bestFree());
+  Move mv({}, {j});
+  if(j == -1 || S.gain(mv) <= 0) return false;
+
+  S.apply(mv);
+  return true;
+}
+
+bool one_oneExchange(
+    SolutionState& S,
+    bool deep) {
+  const int* C(S.costs());
+  int best_gain(0), cmin(INT_MAX);
+  Move mv({-1}, {-1}), best_move;
+  for(int i : S.selected()) cmin = std::min(cmin, C[i]);
+
+  for(int j : S.byCost()) {
+    // The candidates left can't do better than replacing the cheapest
+    // selected variable
+    if(S.selected().empty() || C[j] - cmin <= best_gain) break;
+    // j  can only replace its unique blocker (selected variables have none)
+    if(S.blocking(j) != 1) continue;
+    mv.in[0] = j;
+    S.blockers(j, mv.out, 1);
+    if(S.gain(mv) > best_gain) {
+      best_gain = S.gain(mv), best_move = mv;
+      if(!deep) break;
     }
-    x[i] = 0;
   }
 
-  if(best_move != -1) {
-    x[best_move] = 1, *z = best_z;
-    for(c = 0; c < m && column; c++)
-      column[c] += A[INDEX(best_move, c)];
-  }
+  if(!best_move.empty()) S.apply(best_move);
 
-  return best_move != -1;
+  return !best_move.empty();
 }
 
-bool one_oneExchange(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column) {
-  int c(-1), tmp_z(-1), best_z(*z);
-  std::tuple<int, int> best_move(-1, -1);
-  std::forward_list<int> idx0, idx1;
-  std::tie(idx0, idx1) = find01<std::forward_list<int>>(n, x);
-
-  for(int i : idx1) {
-    x[i] = 0;
-    for(int j : idx0) {
-      if(i != j) {
-        x[j] = 1, tmp_z = *z - C[i] + C[j];
-        if(tmp_z > best_z) {
-          for(c = 0; c < m && column; c++)
-            column[c] += A[INDEX(j, c)] - A[INDEX(i, c)];
-          if(isFeasible(m, n, C, A, x, column, false)) {
-            if(deep)
-              best_z = tmp_z, best_move = std::make_tuple(i, j);
-            else return (*z = tmp_z);
-          }
-          for(c = 0; c < m && column; c++)
-            column[c] += A[INDEX(i, c)] - A[INDEX(j, c)];
-        }
-        x[j] = 0;
+bool two_oneExchange(
+    SolutionState& S,
+    bool deep) {
+  const int* C(S.costs());
+  int best_gain(0), nb(0), t(0);
+  int cheap[3] = { -1, -1, -1 };
+  Move mv({-1, -1}, {-1}), best_move;
+  if(S.selected().size() < 2) return false;
+
+  // The three cheapest selected variables complete the pairs of the
+  // variables blocked by less than two selected variables
+  for(int i : S.selected())
+    for(t = 0; t < 3; t++)
+      if(cheap[t] == -1 || C[i] < C[cheap[t]]) {
+        std::swap(cheap[t], i);
+        if(i == -1) break;
       }
+
+  for(int k : S.byCost()) {
+    // The candidates left can't do better than replacing the two cheapest
+    // selected variables
+    if(C[k] - C[cheap[0]] - C[cheap[1]] <= best_gain) break;
+    // k  can only replace its blockers (and any other selected variables)
+    if(S.x()[k] || S.blocking(k) > 2) continue;
+    nb = S.blockers(k, mv.out, 2);
+    for(t = 0; nb < 2; t++)
+      if(nb == 0 || cheap[t] != mv.out[0]) mv.out[nb++] = cheap[t];
+    mv.in[0] = k;
+    if(S.gain(mv) > best_gain) {
+      best_gain = S.gain(mv), best_move = mv;
+      if(!deep) break;
     }
-    x[i] = 1;
   }
 
-  int i, j;
-  std::tie(i, j) = best_move;
-  if((deep = i != -1 && j != -1)) {
-    x[i] = 0, x[j] = 1, *z = best_z;
-    for(c = 0; c < m && column; c++)
-      column[c] += A[INDEX(j, c)] - A[INDEX(i, c)];
-  }
+  if(!best_move.empty()) S.apply(best_move);
 
-  return deep;
+  return !best_move.empty();
 }
 
-void combinations(
-    // heuristic variables
-    int m,
-    int n,
-    const int *C,
-    const char *A,
-    char *x,
-    int *z,
-    bool deep,
-    char* column,
-    // indices list (for variables set to 0)
-    // and additional variables
-    bool *stop,
-    int *best_z,
-    std::tuple<int, int, int>& best_move,
-    const std::deque<int> &idx0,
-    // variables useful to build up the combinations
-    int *pair_of_1,
-    std::deque<int>::iterator start,
-    std::deque<int>::iterator end,
-    int depth) {
-  if(*stop) return ;
-
-  // Current combination is ready to be used
-  if(depth == 2) {
-    int c(-1);
-    x[pair_of_1[0]] = 0, x[pair_of_1[1]] = 0;
-
-    for(int k : idx0) {
-      if(pair_of_1[0] != k && pair_of_1[1] != k) {
-        // Repurpose depth
-        x[k] = 1, depth = *z - C[pair_of_1[0]] - C[pair_of_1[1]] + C[k];
-        if(depth > *best_z) {
-          for(c = 0; c < m && column; c++)
-            column[c] +=  A[INDEX(k, c)]
-                  - A[INDEX(pair_of_1[0], c)]
-                  - A[INDEX(pair_of_1[1], c)];
-          if(isFeasible(m, n, C, A, x, column, false)) {
-            if(deep) {
-              *best_z = depth;
-              best_move = std::make_tuple(pair_of_1[0],
-                            pair_of_1[1],
-                            k);
-            } else {
-              *stop = true, *z = depth;
-              return ;
-            }
-          }
-          for(c = 0; c < m && column; c++)
-            column[c] +=  A[INDEX(pair_of_1[0], c)]
-                  + A[INDEX(pair_of_1[1], c)]
-                  - A[INDEX(k, c)];
-        }
-        x[k] = 0;
+bool kpExchange(
+    SolutionState& S,
+    Neighbourhood nb,
+    bool deep) {
+  const int* C(S.costs());
+  const ConstraintMatrix* A(S.matrix());
+  int k(std::min(nb.k, _MOVE_MAX_)), best_gain(0), nOut(0), n2(0), t(0), t2(0), cOut(0);
+  nnz_t len(0);
+  int out[_MOVE_MAX_], out2[_MOVE_MAX_];
+  bool stop(false);
+  Move mv, best_move;
+  m_assert(nb.p == 1 || nb.p == 2, "Only 1 or 2 variables can enter x");
+
+  if(nb.p == 1) {
+    mv.nIn = 1;
+    for(int j : S.byCost()) {
+      // The candidates left can't do better than being inserted for free
+      if(C[j] <= best_gain) break;
+      if(S.x()[j] || S.blocking(j) > k) continue;
+      mv.in[0] = j, mv.nOut = S.blockers(j, mv.out, k);
+      if(S.gain(mv) > best_gain) {
+        best_gain = S.gain(mv), best_move = mv;
+        if(!deep) break;
       }
     }
-
-    x[pair_of_1[0]] = 1, x[pair_of_1[1]] = 1;
   } else {
-    // Replace index with all possible elements.
-    for(std::deque<int>::iterator it = start;
-      it != end && end - it+1 >= 2-depth;
-      ++it) {
-      pair_of_1[depth] = *it;
-      combinations(m, n, C, A, x, z, deep, column, stop,
-          best_z, best_move, idx0, pair_of_1, it+1, end, depth+1);
+    mv.nIn = 2;
+    const std::vector<int>& order(S.byCost());
+    // Tries  j1  with  j2  if they share a blocker (and no row)
+    auto pair = [&](int j1, int j2) {
+      // Blockers of  j1  and  j2  (at most  k )
+      std::copy(out, out + nOut, mv.out), mv.nOut = nOut;
+      n2 = S.blockers(j2, out2, k);
+      for(t2 = 0; t2 < n2 && mv.nOut <= k; t2++) {
+        if(std::find(out, out + nOut, out2[t2]) != out + nOut) continue;
+        if(mv.nOut == k) mv.nOut = k + 1;
+        else mv.out[mv.nOut++] = out2[t2];
+      }
+      if(mv.nOut > k || mv.nOut == nOut + n2 || A->share(j1, j2)) return;
+      mv.in[0] = j1, mv.in[1] = j2;
+      if(S.gain(mv) > best_gain) {
+        best_gain = S.gain(mv), best_move = mv;
+        stop = !deep;
+      }
+    };
+
+    for(int j1 : order) {
+      // The second variable is cheaper than the first one
+      if(stop || 2 * C[j1] <= best_gain) break;
+      if(S.x()[j1] || !S.blocking(j1) || S.blocking(j1) > k) continue;
+      nOut = S.blockers(j1, out, k);
+      for(t = 0, cOut = 0, len = 0; t < nOut; t++) {
+        cOut += C[out[t]];
+        for(const int *r = A->rows(out[t]), *e = r + A->nbRows(out[t]); r != e; r++)
+          len += A->nbVars(*r);
+      }
+      // The second variable is cheaper than  j1 , can improve on the best
+      // move and shares a blocker with  j1  : it is in a row of a blocker of
+      // j1 . These rows are listed unless they hold more variables than the
+      // ones which can improve on the best move (tried in order then)
+      auto first(order.begin() + S.rank(j1) + 1), last(std::partition_point(
+          first, order.end(), [&](int v) { return C[j1] + C[v] - cOut > best_gain; }));
+      if(last - first <= len) {
+        for(auto it = first; it != last && !stop; ++it) {
+          if(C[j1] + C[*it] - cOut <= best_gain) break;
+          if(!S.x()[*it] && S.blocking(*it) && S.blocking(*it) <= k) pair(j1, *it);
+        }
+        continue;
+      }
+      for(t = 0; t < nOut && !stop; t++)
+        for(const int *r = A->rows(out[t]), *e = r + A->nbRows(out[t]); r != e && !stop; r++)
+          for(const int *v = A->vars(*r), *f = v + A->nbVars(*r); v != f && !stop; v++) {
+            if(S.rank(*v) <= S.rank(j1) || C[j1] + C[*v] - cOut <= best_gain) continue;
+            if(S.x()[*v] || S.blocking(*v) > k) continue;
+            // j2  is only tried from the first of its rows owned by a blocker
+            // of  j1
+            const int* s(A->rows(*v));
+            while(std::find(out, out + nOut, S.owner(*s)) == out + nOut) s++;
+            if(*s == *r) pair(j1, *v);
+          }
     }
   }
+
+  if(!best_move.empty()) S.apply(best_move);
+
+  return !best_move.empty();
 }
 
-bool two_oneExchange(
-    int m,
-    int n,
-    const int* C,
-    const char* A,
-    char* x,
-    int* z,
-    bool deep,
-    char* column) {
-  bool stop(false);
-  int best_z(*z);
-  int pair_of_1[2] = { -1, -1 };
-  std::deque<int> idx0, idx1;
-  std::tuple<int, int, int> best_move(-1, -1, -1);
-  std::tie(idx0, idx1) = find01<std::deque<int>>(n, x);
-
-  combinations(m, n, C, A, x, z, deep, column, &stop, &best_z,
-      best_move, idx0, pair_of_1, idx1.begin(), idx1.end(), 0);
-
-  int i(-1), j(-1), k(-1); std::tie(i, j, k) = best_move;
-  if((deep = i != -1 && j != -1 && k != -1)) {
-    x[i] = 0, x[j] = 0, x[k] = 1, *z = best_z;
-    for(int c = 0; c < m && column; c++)
-      column[c] +=  A[INDEX(k, c)]
-            - A[INDEX(i, c)]
-            - A[INDEX(j, c)];
-  }
+bool queueExchange(
+    SolutionState& S,
+    const std::vector<Neighbourhood>& neighbourhoods,
+    bool deep) {
+  const int* C(S.costs());
+  bool improved(false), listed[_MOVE_MAX_ + 1] = {};
+  int j(-1), best(-1), left(0);
+  Move mv({}, {-1});
+  for(Neighbourhood nb : neighbourhoods)
+    if(nb.p == 1 && nb.k >= 0 && nb.k <= _MOVE_MAX_) listed[nb.k] = true;
+
+  // Each round pops the variables queued when it starts : the first
+  // improving one is applied at once, or the best one at the end of the
+  // round ( deep , the other improving ones are queued again)
+  do {
+    best = -1;
+    for(left = S.queued(); left > 0; left--) {
+      j = S.nextCandidate();
+      // The gain is known without looking for the blockers
+      if(S.x()[j] || S.blocking(j) > _MOVE_MAX_ || !listed[S.blocking(j)]
+          || C[j] <= S.blockingCost(j))
+        continue;
+      if(!deep) {
+        mv.in[0] = j, mv.nOut = S.blockers(j, mv.out, _MOVE_MAX_);
+        S.apply(mv), improved = true;
+      } else if(best != -1 && C[j] - S.blockingCost(j) <= C[best] - S.blockingCost(best)) {
+        S.wake(j);
+      } else {
+        if(best != -1) S.wake(best);
+        best = j;
+      }
+    }
+    if(best != -1) {
+      mv.in[0] = best, mv.nOut = S.blockers(best, mv.out, _MOVE_MAX_);
+      S.apply(mv), improved = true;
+    }
+  } while(deep ? best != -1 : S.queued() > 0);
+
+  return improved;
+}
 
-  return deep;
+bool exchange(
+    SolutionState& S,
+    Neighbourhood nb,
+    bool deep) {
+  if(nb.p == 1 && nb.k == 0) return zero_oneExchange(S, deep);
+  if(nb.p == 1 && nb.k == 1) return one_oneExchange(S, deep);
+  if(nb.p == 1 && nb.k == 2) return two_oneExchange(S, deep);
+  return kpExchange(S, nb, deep);
 }
@@ -0,0 +1,122 @@
+#include "pipeline.hpp"
+
+InstancePrefetcher::InstancePrefetcher(
+    std::string path,
+    std::vector<std::string> fnames,
+    bool cache,
+    bool conflicts,
+    bool presolve,
+    size_t budget,
+    bool background) :
+  path(path), fnames(fnames), cache(cache),
+  conflicts(conflicts), presolve(presolve), background(background),
+  budget(budget) {
+  if(background) worker = std::thread(&InstancePrefetcher::run, this);
+}
+
+InstancePrefetcher::~InstancePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cv.notify_all();
+  if(worker.joinable()) worker.join();
+}
+
+LoadedInstance InstancePrefetcher::load(const std::string& fname) {
+  LoadedInstance li; INIT_TIMER();
+  li.name = fname;
+  TIMED(li.t,
+    std::tie(li.m, li.n, li.C, li.A, li.U) = loadSPP(path + fname,
+      cache, false, &li.tParse);
+    if(conflicts && !presolve) li.A->buildConflicts(!background)
+  );
+  // The conflict graph is built on the reduced instance
+  if(presolve && li.n >= 0) {
+    TIMED(li.tp, li.P = presolveSPP(li.m, li.n, li.C, li.A, li.U));
+    if(conflicts) li.A->buildConflicts(!background);
+  }
+  li.bytes = li.A->memory() + std::max(li.n, 0) * (sizeof(int) + sizeof(float));
+  return li;
+}
+
+void InstancePrefetcher::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while(!stop && loaded < fnames.size()) {
+    // Wait for room in the budget (always load at least one ahead)
+    cv.wait(lock, [this] { return stop || ready.empty() || inFlight < budget; });
+    if(stop) break;
+    std::string fname(fnames[loaded]);
+    lock.unlock();
+    LoadedInstance li;
+    try {
+      li = load(fname);
+    } catch(...) {
+      // Handed to the main thread by next()
+      lock.lock();
+      error = std::current_exception();
+      cv.notify_all();
+      return ;
+    }
+    lock.lock();
+    inFlight += li.bytes, loaded++;
+    ready.push_back(std::move(li));
+    cv.notify_all();
+  }
+}
+
+LoadedInstance InstancePrefetcher::next() {
+  if(!background) return load(fnames[taken++]);
+
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [this] { return !ready.empty() || error; });
+  if(ready.empty()) std::rethrow_exception(error);
+  LoadedInstance li(std::move(ready.front()));
+  ready.pop_front();
+  inFlight -= li.bytes, taken++;
+  cv.notify_all();
+  return li;
+}
+
+TaskQueue::TaskQueue(bool background) : background(background) {
+  if(background) worker = std::thread(&TaskQueue::run, this);
+}
+
+TaskQueue::~TaskQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cv.notify_all();
+  if(worker.joinable()) worker.join();
+}
+
+void TaskQueue::push(std::function<void()> task) {
+  if(!background) { task(); return ; }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    tasks.push_back(std::move(task));
+  }
+  cv.notify_all();
+}
+
+void TaskQueue::wait() {
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [this] { return tasks.empty() && !busy; });
+}
+
+void TaskQueue::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  // Pending tasks are still run once stop is requested
+  while(!stop || !tasks.empty()) {
+    cv.wait(lock, [this] { return stop || !tasks.empty(); });
+    if(tasks.empty()) continue;
+    std::function<void()> task(std::move(tasks.front()));
+    tasks.pop_front(), busy = true;
+    lock.unlock();
+    task();
+    lock.lock();
+    busy = false;
+    cv.notify_all();
+  }
+}
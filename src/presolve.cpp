@@ -0,0 +1,142 @@
+#include "presolve.hpp"
+
+std::vector<char> Postsolve::restore(const char* x) const {
+  std::vector<char> full(n, 0);
+  for(size_t j = 0; j < col.size(); j++) full[col[j]] = x[j];
+  for(int j : ones) full[j] = 1;
+  return full;
+}
+
+// Keeps the variables and rows of  A  flagged in  keepCol  and  keepRow
+// (renumbered in the same order) and updates  C  and  col  accordingly
+static void reduce(
+    ConstraintMatrix& A,
+    int* C,
+    std::vector<int>& col,
+    const std::vector<char>& keepCol,
+    const std::vector<char>& keepRow) {
+  int i(0), j(0), k(0);
+  nnz_t l(0);
+  std::vector<int> idx(A.n, -1), rowVar;
+  std::vector<nnz_t> rowBeg(1, 0);
+
+  for(j = 0, k = 0; j < A.n; j++)
+    if(keepCol[j]) idx[j] = k, C[k] = C[j], col[k] = col[j], k++;
+  A.n = k, col.resize(k);
+
+  rowVar.reserve(A.nnz);
+  for(i = 0; i < A.m; i++) {
+    if(!keepRow[i]) continue;
+    for(l = A.rowBeg[i]; l < A.rowBeg[i+1]; l++)
+      if(idx[A.rowVar[l]] != -1) rowVar.push_back(idx[A.rowVar[l]]);
+    rowBeg.push_back(rowVar.size());
+  }
+  A.m = rowBeg.size() - 1;
+  A.rowBeg = std::move(rowBeg), A.rowVar = std::move(rowVar);
+  A.buildColumns();
+}
+
+// Stores in  out  the sets (rows or variables) which may contain all the
+// sorted elements  elems[0] ... elems[size-1] : the sets containing both
+// elements of  elems  belonging to the fewest sets, given by  sets(e)  and
+// nbSets(e)  (sorted too)
+template<typename Sets, typename NbSets>
+static void candidates(
+    const int* elems,
+    int size,
+    Sets sets,
+    NbSets nbSets,
+    std::vector<int>& out) {
+  int a(0), b(-1);
+  for(int e = 1; e < size; e++) {
+    if(nbSets(elems[e]) < nbSets(elems[a])) b = a, a = e;
+    else if(b == -1 || nbSets(elems[e]) < nbSets(elems[b])) b = e;
+  }
+  out.clear();
+  if(b == -1) out.assign(sets(elems[a]), sets(elems[a]) + nbSets(elems[a]));
+  else std::set_intersection(
+      sets(elems[a]), sets(elems[a]) + nbSets(elems[a]),
+      sets(elems[b]), sets(elems[b]) + nbSets(elems[b]),
+      std::back_inserter(out));
+}
+
+Postsolve presolveSPP(
+    int& m,
+    int& n,
+    std::unique_ptr<int[]>& C,
+    std::unique_ptr<ConstraintMatrix>& A,
+    std::unique_ptr<float[]>& U) {
+  bool changed(true);
+  int i(0), j(0), k(0);
+  Postsolve P;
+  std::vector<int> cand;
+  P.m = m, P.n = n, P.col.resize(n);
+  std::iota(P.col.begin(), P.col.end(), 0);
+  // Returns true if variable  k  is preferred to variable  j
+  auto better = [&C, &A](int k, int j) {
+    return C[k] > C[j] || (C[k] == C[j] && (A->nbRows(k) < A->nbRows(j)
+      || (A->nbRows(k) == A->nbRows(j) && k < j)));
+  };
+  auto vars = [&A](int i) { return A->vars(i); };
+  auto nbVars = [&A](int i) { return A->nbVars(i); };
+  auto rows = [&A](int j) { return A->rows(j); };
+  auto nbRows = [&A](int j) { return A->nbRows(j); };
+
+  while(changed) {
+    changed = false;
+
+    /* Variables */
+    std::vector<char> keepCol(A->n, 1), keepRow(A->m, 1);
+    for(j = 0; j < A->n; j++) {
+      if(C[j] <= 0 || !A->nbRows(j)) {
+        keepCol[j] = 0, P.fixedCols++;
+        if(C[j] > 0) P.ones.push_back(P.col[j]), P.offset += C[j];
+      }
+    }
+    // Variables  j  covering every row of a kept variable  k  (candidates
+    // appear in the rows of  k ) are removed if  k  is better. Removing
+    // them is safe since the best of such chains is never removed.
+    for(k = 0; k < A->n; k++) {
+      if(!keepCol[k]) continue;
+      candidates(A->rows(k), A->nbRows(k), vars, nbVars, cand);
+      for(int j : cand)
+        if(j != k && keepCol[j] && better(k, j) && std::includes(
+              A->rows(j), A->rows(j) + A->nbRows(j),
+              A->rows(k), A->rows(k) + A->nbRows(k)))
+          keepCol[j] = 0, P.dominatedCols++;
+    }
+    if(std::find(keepCol.begin(), keepCol.end(), 0) != keepCol.end()) {
+      reduce(*A, C.get(), P.col, keepCol, keepRow);
+      keepCol.assign(A->n, 1), keepRow.assign(A->m, 1), changed = true;
+    }
+
+    /* Rows */
+    for(i = 0; i < A->m; i++) {
+      if(A->nbVars(i) < 2) {
+        keepRow[i] = 0, P.redundantRows++;
+        continue;
+      }
+      // Row  i  is removed if a bigger row (or the same with a smaller
+      // index) holds all its variables
+      candidates(A->vars(i), A->nbVars(i), rows, nbRows, cand);
+      for(int s : cand)
+        if(s != i && keepRow[i]
+            && (A->nbVars(s) > A->nbVars(i) || s < i) && std::includes(
+              A->vars(s), A->vars(s) + A->nbVars(s),
+              A->vars(i), A->vars(i) + A->nbVars(i)))
+          keepRow[i] = 0, P.redundantRows++;
+    }
+    if(std::find(keepRow.begin(), keepRow.end(), 0) != keepRow.end()) {
+      reduce(*A, C.get(), P.col, keepCol, keepRow);
+      changed = true;
+    }
+  }
+
+  // Shrink C and recompute the utilities of the remaining variables
+  m = A->m, n = A->n;
+  std::unique_ptr<int[]> C2 = std::make_unique<int[]>(n);
+  std::copy(C.get(), C.get() + n, C2.get());
+  C = std::move(C2), U = std::make_unique<float[]>(n);
+  for(j = 0; j < n; j++) U[j] = C[j]/(float)A->nbRows(j);
+  return P;
+}
@@ -0,0 +1,101 @@
+#include "solution.hpp"
+
+SolutionState::SolutionState(
+    int m,
+    int n,
+    const int* C,
+    const ConstraintMatrix* A) :
+  _m(m), _n(n), _z(0), _C(C), _A(A),
+  _x(n, 0), _pos(n, 0),
+  _block(n, 0), _blockCost(n, 0), _owner(m, -1), _byCost(n), _rank(n),
+  _queue(n), _look(n),
+  _qHead(0), _qSize(0), _stamp(0) {
+  if(!A->conflicts.built()) _mark.assign(n, 0);
+  for(size_t c = n; _free.empty() || _free.back().size() > 1; c = _free.back().size())
+    _free.emplace_back(std::max<size_t>((c + 63) / 64, 1));
+  std::iota(_byCost.begin(), _byCost.end(), 0);
+  std::stable_sort(_byCost.begin(), _byCost.end(),
+      [C](int i, int j) { return C[i] > C[j]; });
+  for(int r = 0; r < n; r++) _rank[_byCost[r]] = r;
+  _sel.reserve(n), _unsel.reserve(n);
+  reset();
+}
+
+void SolutionState::reset() {
+  std::fill(_x.begin(), _x.end(), 0);
+  _sel.clear(), _unsel.resize(_n);
+  std::iota(_unsel.begin(), _unsel.end(), 0);
+  std::iota(_pos.begin(), _pos.end(), 0);
+  std::fill(_block.begin(), _block.end(), 0);
+  std::fill(_blockCost.begin(), _blockCost.end(), 0);
+  std::fill(_owner.begin(), _owner.end(), -1);
+  // Every variable is free
+  for(size_t l = 0, c = _n; l < _free.size(); c = _free[l++].size()) {
+    std::fill(_free[l].begin(), _free[l].end(), ~uint64_t(0));
+    if(c % 64) _free[l].back() = (uint64_t(1) << (c % 64)) - 1;
+    if(!c) _free[l].back() = 0;
+  }
+  // Every variable has to be looked at
+  std::iota(_queue.begin(), _queue.end(), 0);
+  std::fill(_look.begin(), _look.end(), 1);
+  _qHead = 0, _qSize = _n;
+  _z = 0, _last = Move();
+}
+
+void SolutionState::assign(const char* x) {
+  reset();
+  for(int j = 0; j < _n; j++) if(x[j]) insert(j);
+}
+
+void SolutionState::insert(int j) {
+  if(_x[j]) return;
+  // Swap  j  with the last unselected variable then move it to  _sel
+  int last(_unsel.back());
+  _unsel[_pos[j]] = last, _pos[last] = _pos[j], _unsel.pop_back();
+  _pos[j] = _sel.size(), _sel.push_back(j);
+  _x[j] = 1, _z += _C[j];
+  for(const int *r = _A->rows(j), *e = r + _A->nbRows(j); r != e; r++)
+    _owner[*r] = j;
+  setFree(j, false);
+  block(j, 1);
+}
+
+void SolutionState::remove(int j) {
+  if(!_x[j]) return;
+  int last(_sel.back());
+  _sel[_pos[j]] = last, _pos[last] = _pos[j], _sel.pop_back();
+  _pos[j] = _unsel.size(), _unsel.push_back(j);
+  _x[j] = 0, _z -= _C[j];
+  for(const int *r = _A->rows(j), *e = r + _A->nbRows(j); r != e; r++)
+    _owner[*r] = -1;
+  block(j, -1);
+  // The neighbours of  j  being unselected,  j  is free
+  setFree(j, true);
+  wake(j);
+}
+
+void SolutionState::block(int j, int v) {
+  const ConstraintMatrix* A(_A);
+  if(A->conflicts.built()) {
+    for(int k = 0; k < A->conflicts.degree(j); k++)
+      count(A->conflicts.neighbours(j)[k], v, _C[j]);
+    return ;
+  }
+  // Neighbours of  j  through its rows, each one counted once
+  _stamp++, _mark[j] = _stamp;
+  for(const int *r = A->rows(j), *e = r + A->nbRows(j); r != e; r++)
+    for(const int *k = A->vars(*r), *f = k + A->nbVars(*r); k != f; k++)
+      if(_mark[*k] != _stamp) _mark[*k] = _stamp, count(*k, v, _C[j]);
+}
+
+void SolutionState::apply(const Move& mv) {
+  for(int t = 0; t < mv.nOut; t++) remove(mv.out[t]);
+  for(int t = 0; t < mv.nIn; t++) insert(mv.in[t]);
+  _last = mv;
+}
+
+void SolutionState::undo() {
+  for(int t = 0; t < _last.nIn; t++) remove(_last.in[t]);
+  for(int t = 0; t < _last.nOut; t++) insert(_last.out[t]);
+  _last = Move();
+}
@@ -0,0 +1,65 @@
+// Counts the allocations of ReactiveGRASP() (global operator new replaced)
+// for 200 and 800 iterations : the buffers being allocated once per run and
+// reused by every iteration, both counts must be equal (with the static
+// and the adaptive constructions, with and without the queue)
+#include "heuristics.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+static std::atomic<long> allocations(0);
+
+void* operator new(std::size_t size) {
+  allocations++;
+  if(void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Allocations of a run of  nbIter  iterations
+static long countAllocations(
+    int m,
+    int n,
+    const int* C,
+    const ConstraintMatrix* A,
+    const float* U,
+    int nbIter,
+    bool queue,
+    bool adaptive) {
+  std::vector<int> zInits(nbIter), zAmels(nbIter), zBests(nbIter);
+  std::vector<double> alpha({0.0, 0.3, 0.6, 0.9}), proba(alpha.size(), 0.25);
+  long before(allocations);
+  ReactiveGRASP(m, n, C, A, U, zInits, zAmels, zBests, alpha, proba, 50, 4,
+      nbIter, true, true, { {2, 1}, {1, 1}, {0, 1} }, queue, adaptive);
+  return allocations - before;
+}
+
+int main() {
+  int m(0), n(0), failures(0);
+  std::unique_ptr<int[]> C;
+  std::unique_ptr<ConstraintMatrix> A;
+  std::unique_ptr<float[]> U;
+  std::tie(m, n, C, A, U) = loadSPP("instances/pb_200rnd0100.dat");
+  if(n < 0) return 1;
+  // Starts the OpenMP threads (and whatever they allocate once)
+  countAllocations(m, n, C.get(), A.get(), U.get(), 50, false, false);
+
+  for(bool adaptive : { false, true })
+    for(bool queue : { false, true }) {
+      long a200(countAllocations(m, n, C.get(), A.get(), U.get(), 200, queue, adaptive));
+      long a800(countAllocations(m, n, C.get(), A.get(), U.get(), 800, queue, adaptive));
+      if(a200 != a800) {
+        std::cout << (adaptive ? "adaptive" : "static") << (queue ? ", queue" : "")
+                  << " : " << a200 << " allocations for 200 iterations, "
+                  << a800 << " for 800" << std::endl;
+        failures++;
+      }
+    }
+
+  std::cout << "alloc_test : 4 configurations compared, " << failures
+            << " failure(s)" << std::endl;
+  return failures != 0;
+}
@@ -0,0 +1,100 @@
+// Compares two_oneExchange() with a reference trying every pair of selected
+// variables with every unselected variable, along descents from random
+// constructions :
+//  * deep descents : both must find a move (or none) at the same time and
+//    reach the same value of  z
+//  * first improvement : both must find a move (or none) at the same time
+//    and the move of two_oneExchange() must improve  z
+#include "heuristics.hpp"
+
+#include <iostream>
+
+// Tries all non-symmetrical pairs of variables set to 1 with every variable
+// set to 0 (by decreasing cost : the loop stops at the first one that can't
+// improve on the best move)
+static void combinations(
+    const SolutionState& S,
+    bool deep,
+    int* best_gain,
+    Move& best_move) {
+  const int* C(S.costs());
+  const char* x(S.x());
+  const std::vector<int> &idx0(S.byCost()), &idx1(S.selected());
+  bool stop(false);
+  int base(0);
+  size_t p(0), q(0), k(0);
+  Move mv({-1, -1}, {-1});
+
+  for(p = 0; p + 1 < idx1.size() && !stop; p++) {
+    for(q = p + 1; q < idx1.size() && !stop; q++) {
+      mv.out[0] = idx1[p], mv.out[1] = idx1[q];
+      base = -C[mv.out[0]] - C[mv.out[1]];
+      for(k = 0; k < idx0.size(); k++) {
+        if(x[idx0[k]]) continue;
+        if(C[idx0[k]] + base <= *best_gain) break;
+        mv.in[0] = idx0[k];
+        if(S.isFeasible(mv)) {
+          *best_gain = S.gain(mv), best_move = mv;
+          if((stop = !deep)) break;
+        }
+      }
+    }
+  }
+}
+
+// Reference 21-exchange (in O(|x1|^2 * |x0|) moves)
+static bool two_oneExchangeAllPairs(
+    SolutionState& S,
+    bool deep) {
+  int best_gain(0);
+  Move best_move;
+
+  combinations(S, deep, &best_gain, best_move);
+  if(!best_move.empty()) S.apply(best_move);
+
+  return !best_move.empty();
+}
+
+int main() {
+  const std::string path("instances/");
+  int failures(0), calls(0);
+
+  for(std::string fname : { "didactic.dat", "pb_100rnd0100.dat",
+      "pb_200rnd0100.dat", "pb_200rnd0500.dat", "pb_500rnd0700.dat" }) {
+    int m(0), n(0);
+    std::unique_ptr<int[]> C;
+    std::unique_ptr<ConstraintMatrix> A;
+    std::unique_ptr<float[]> U;
+    std::tie(m, n, C, A, U) = loadSPP(path + fname);
+    if(n < 0) return 1;
+    SolutionState S(m, n, C.get(), A.get()), R(m, n, C.get(), A.get());
+
+    for(int it = 0; it < 40; it++) {
+      bool deep(it % 2 == 0), improved(true);
+      GreedyRandomized(S, U.get(), 0.6f);
+      while(improved) {
+        int z(S.z());
+        R.assign(S.x());
+        bool ref(two_oneExchangeAllPairs(R, deep));
+        improved = two_oneExchange(S, deep), calls++;
+        if(improved != ref || (deep && S.z() != R.z()) || (improved && S.z() <= z)) {
+          std::cout << fname << (deep ? " (deep)" : " (first)")
+                    << " : two_oneExchange z = " << S.z()
+                    << ", reference z = " << R.z() << " from z = " << z << std::endl;
+          failures++;
+          break;
+        }
+        // Reach the next local optimum of the smaller neighbourhoods
+        while(one_oneExchange(S, deep) || zero_oneExchange(S, deep)) improved = true;
+      }
+      if(!isFeasible(m, n, C.get(), A.get(), S.x(), false)) {
+        std::cout << fname << " : infeasible solution" << std::endl;
+        failures++;
+      }
+    }
+  }
+
+  std::cout << "exchange_test : " << calls << " calls compared, "
+            << failures << " failure(s)" << std::endl;
+  return failures != 0;
+}